@@ -21,137 +21,182 @@
 
 #include <WiFi.h>
 
-#include "lwip/ip.h"
 #include "lwip/sockets.h"
 
 #include <cmath>
-#include <sys/time.h>
 
 /// @brief
-/// @param sock_fd
-/// @param seq_num
+/// @param ip4
+/// @param request
 /// @return
-bool Esp32IcmpPing::Send(uint32_t ip4, int sock_fd, const uint16_t seq_num)
+PingStatus Esp32IcmpPing::Send(uint32_t ip4, const IcmpPacket &request)
 {
-	const IcmpEchoRequest request(seq_num);
-	// Target address
-	sockaddr_in to;
-	memset(&to, 0, sizeof(to));
-	to.sin_len = sizeof(to);
-	to.sin_family = AF_INET;
-	to.sin_addr.s_addr = ip4;
-	return sendto(sock_fd, request.Data(), request.Size(), 0, reinterpret_cast<sockaddr *>(&to), sizeof(to)) > 0;
+	const PingStats::PhaseTimer timer(_stats, Transport(), PingStats::PHASE_SEND);
+	const auto status = Transport().Send(ip4, request.Data(), request.Size());
+	if (!status)
+	{
+		_stats.AddError(status.ErrorNo());
+		return Report<PING_LOG_LEVEL_ERROR>(status);
+	}
+	_stats.AddSent(request.Size());
+	return status;
 }
 
 /// @brief
-/// @param sock_fd
+/// @param replyType
 /// @param seq_num
+/// @param timeoutUs
+/// @param reply
+/// @param replySize
+/// @param replyLen
 /// @param elapsed
 /// @return
-bool Esp32IcmpPing::Receive(const int sock_fd, const uint16_t seq_num, float &elapsedMs, bool &canContinue)
+PingStatus Esp32IcmpPing::Receive(const uint8_t replyType, const uint16_t seq_num, const uint32_t timeoutUs,
+								  unsigned char *reply, const uint16_t replySize, uint16_t &replyLen,
+								  float &elapsedMs, bool &canContinue)
 {
-	// Recv 2 headers 8 + 20 == 28 bytes
-	constexpr mem_size_t echo_recv_byte_hdr = sizeof(ip_hdr) + sizeof(icmp_echo_hdr);
-	constexpr mem_size_t min_echo_recv_byte_count = 64;
+	const PingStats::PhaseTimer timer(_stats, Transport(), PingStats::PHASE_RECEIVE);
 	elapsedMs = 0.0f;
+	replyLen = 0u;
 	canContinue = false;
 	// Register begin time
-	timeval begin;
-	gettimeofday(&begin, nullptr);
-	// Recv
-	sockaddr_in from;
-	socklen_t from_len = sizeof(from);
-	unsigned char echo_packet[min_echo_recv_byte_count];
-	const auto len = recvfrom(sock_fd, echo_packet, sizeof(echo_packet), 0,
-							  reinterpret_cast<sockaddr *>(&from), &from_len);
-	if (len < 0)
+	const auto beginUs = Transport().NowUs();
+	auto remainingUs = timeoutUs;
+	for (;;)
 	{
-		auto e = errno;
-		if (e == EAGAIN || e == EWOULDBLOCK)
+		// Recv
+		uint32_t fromIp4 = 0u;
+		auto status = Transport().Receive(reply, replySize, replyLen, fromIp4, remainingUs);
+		switch (status.Error())
 		{
+		case PING_OK:
+			break;
+		case PING_ERR_TIMEOUT:
+			_stats.AddTimeout();
 			canContinue = true;
-			return ErrorLn("Timed out", errno);
+			return Report<PING_LOG_LEVEL_WARN>(status);
+		case PING_ERR_RESPONSE_TOO_SMALL:
+			_stats.AddInvalidReply();
+			break;
+		default:
+			_stats.AddError(status.ErrorNo());
+			return Report<PING_LOG_LEVEL_ERROR>(status);
+		}
+		if (status)
+		{
+			_stats.AddReceived(replyLen);
+			//  Get echo or timestamp reply
+			bool isValid = false;
+			bool isOurs = false;
+			if (replyType == ICMP_TSR)
+			{
+				const IcmpTimestampResponse timestampResponse(reply, replyLen);
+				isValid = timestampResponse.IsValid(seq_num);
+				isOurs = timestampResponse.IsOurs();
+			}
+			else
+			{
+				const IcmpEchoResponse echoResponse(reply, replyLen);
+				isValid = echoResponse.IsValid(seq_num);
+				isOurs = echoResponse.IsOurs();
+			}
+			if (isValid)
+				break;
+			if (isOurs)
+				_stats.AddLateReply();
+			else
+				_stats.AddInvalidReply();
+			status = Report<PING_LOG_LEVEL_WARN>(PING_ERR_INVALID_RESPONSE);
 		}
-		else
-			return ErrorLn("Bad receive", errno);
+		// Raw sockets see all ICMP traffic - and late replies to earlier probes.
+		// Discard it and wait out the rest of this probe's timeout.
+		const auto waitedUs = Transport().NowUs() - beginUs;
+		if (waitedUs >= timeoutUs)
+		{
+			_stats.AddTimeout();
+			canContinue = true;
+			return Report<PING_LOG_LEVEL_WARN>(PING_ERR_TIMEOUT);
+		}
+		remainingUs = timeoutUs - static_cast<uint32_t>(waitedUs);
 	}
-	if (len == 0)
-		return ErrorLn("Connection closed");
-	if (len < echo_recv_byte_hdr)
-		return ErrorLn("Response too small");
-
-	/// Get from IP address
-	// ip4_addr_t from_addr;
-	// inet_addr_to_ip4addr(&from_addr, &from.sin_addr);
-	//  Get echo
-	const auto ipHeaderBytes = IPH_HL(reinterpret_cast<ip_hdr *>(echo_packet)) * sizeof(uint32_t);
-	const IcmpEchoResponse echoResponse(echo_packet + ipHeaderBytes, len - ipHeaderBytes);
-
-	if (!echoResponse.IsValid(seq_num))
-		return ErrorLn("Invalid response");
-	// Register end time
-	timeval end;
-	gettimeofday(&end, nullptr);
 	// Get elapsed time in milliseconds
-	auto micros_begin = begin.tv_sec * 1000000ul;
-	micros_begin += begin.tv_usec;
-	auto micros_end = end.tv_sec * 1000000ul;
-	micros_end += end.tv_usec;
-	elapsedMs = static_cast<float>(micros_end - micros_begin) / static_cast<float>(1000.0);
+	elapsedMs = static_cast<float>(Transport().NowUs() - beginUs) / static_cast<float>(1000.0);
 	canContinue = true;
 	if (elapsedMs <= 0.0)
-		return ErrorLn("Bad time calc");
-	return true;
+		return Report<PING_LOG_LEVEL_WARN>(PING_ERR_BAD_TIME_CALC);
+	return PingStatus();
 }
 
-/// @brief
-/// @param str
-/// @param errorNo
-/// @return
-bool Esp32IcmpPing::ErrorLn(const char *str, int errorNo)
+/// @brief Default sink is the printer, if any
+/// @param level
+/// @param status
+void Esp32IcmpPing::Log(const uint8_t level, const PingStatus &status)
 {
+	if (_logHandler != nullptr)
+	{
+		_logHandler(level, status, _logContext);
+		return;
+	}
 	if (_printer == nullptr)
-		return false;
-	_printer->print(str);
-	_printer->print("- Error no:");
-	_printer->print(errorNo);
+		return;
+	_printer->print(status.ToString());
+	if (status.ErrorNo() != 0)
+	{
+		_printer->print("- Error no:");
+		_printer->print(status.ErrorNo());
+	}
 	_printer->println();
-	return false;
 }
 
 /// @brief
-/// @param sock_fd
 /// @return
-bool Esp32IcmpPing::CreateAndSetUpSocket(int &sock_fd)
+PingStatus Esp32IcmpPing::CreateAndSetUpSocket()
 {
-	// Create socket
-	sock_fd = socket(AF_INET, SOCK_RAW, IPPROTO_ICMP);
-	if (sock_fd < 0)
-		return ErrorLn("Failed to create socket");
-	// Setup socket
-	timeval tout;
-	// Timeout
-	tout.tv_sec = Options().ReceiveTimeoutSeconds();
-	tout.tv_usec = Options().ReceiveTimeoutMicros();
-
-	// Set receive time out
-	if (setsockopt(sock_fd, SOL_SOCKET, SO_RCVTIMEO, &tout, sizeof(tout)) < 0)
+	const PingStats::PhaseTimer timer(_stats, Transport(), PingStats::PHASE_CREATE_SOCKET);
+	const auto status = Transport().Open();
+	if (!status)
 	{
-		closesocket(sock_fd);
-		return ErrorLn("Failed to set timeout");
+		_stats.AddError(status.ErrorNo());
+		return Report<PING_LOG_LEVEL_ERROR>(status);
 	}
-	return true;
+	return status;
+}
+
+/// @brief
+/// @param rtt
+/// @return
+uint32_t Esp32IcmpPing::ProbeTimeoutUs(const RttEstimator &rtt) const
+{
+	const uint32_t maxUs = Options().ReceiveTimeoutMs() * 1000ul;
+	if (!Options().IsAdaptiveTimeout())
+		return maxUs;
+	return rtt.TimeoutUs(Options().AdaptiveMinTimeoutMs() * 1000ul, maxUs);
+}
+
+/// @brief
+/// @param deadlineUs
+void Esp32IcmpPing::WaitToSend(const int64_t deadlineUs)
+{
+	const PingStats::PhaseTimer timer(_stats, Transport(), PingStats::PHASE_PACING);
+	// Schedule first, then take a token at the time of sending - a token
+	// booked ahead for the slot would hold up every other instance on this clock
+	if (deadlineUs > Transport().NowUs())
+		Transport().WaitUntilUs(deadlineUs);
+	const auto nowUs = Transport().NowUs();
+	const auto sendAtUs = Transport().RateLimiter().Reserve(nowUs);
+	if (sendAtUs > nowUs)
+		Transport().WaitUntilUs(sendAtUs);
 }
 
 /// @brief
 /// @param result
 /// @param printer
 /// @return
-bool Esp32IcmpPing::ping(PingResults &result, Print *printer)
+PingStatus Esp32IcmpPing::ping(PingResults &result, Print *printer)
 {
 	result = PingResults();
 	if (_inPing)
-		return ErrorLn("Already in Ping!");
+		return Report<PING_LOG_LEVEL_ERROR>(PING_ERR_ALREADY_IN_PING);
 	_inPing = true;
 	auto ret = CallPing(result, printer);
 	_inPing = false;
@@ -159,48 +204,73 @@ bool Esp32IcmpPing::ping(PingResults &result, Print *printer)
 }
 
 /// @brief
-/// @param result
+/// @param ip4
 /// @param printer
 /// @return
-bool Esp32IcmpPing::CallPing(PingResults &result, Print *printer)
+PingStatus Esp32IcmpPing::PrepareToPing(uint32_t &ip4, Print *printer)
 {
 	if (printer != nullptr)
 		_printer = printer;
 	// Extract a valid host address
-	uint32_t ip4 = 0u;
-	if (!Options().GetAddress(ip4, _printer))
-		return false;
+	ip4 = 0u;
+	PingStatus status;
+	{
+		const PingStats::PhaseTimer timer(_stats, Transport(), PingStats::PHASE_GET_ADDRESS);
+		status = Options().GetAddress(ip4);
+	}
+	if (!status)
+	{
+		_stats.AddResolveFailure();
+		return Report<PING_LOG_LEVEL_ERROR>(status);
+	}
 	// Check valid
 	if (!Options().IsValid())
-		return ErrorLn("Invalid Options");
-	int sock_fd = -1;
-	if (!CreateAndSetUpSocket(sock_fd))
-		return false;
+		return Report<PING_LOG_LEVEL_ERROR>(PING_ERR_INVALID_OPTIONS);
+	return CreateAndSetUpSocket();
+}
+
+/// @brief
+/// @param result
+/// @param printer
+/// @return
+PingStatus Esp32IcmpPing::CallPing(PingResults &result, Print *printer)
+{
+	uint32_t ip4 = 0u;
+	auto status = PrepareToPing(ip4, printer);
+	if (!status)
+		return status;
 	// Track data
 	uint8_t transmitted = 0u;
 	uint8_t received = 0u;
 	auto time_elapsed_ms = 0u;
-	const auto ping_started_time = millis();
+	const auto ping_started_us = Transport().NowUs();
 	// Calculations
 	float min_time_ms = 1.E+9f; // FLT_MAX;
 	float max_time_ms = 0.0f;
 	// Calc SD
 	float times_ms[PingOptions::MAX_COUNT];
 	float mean_total_ms = 0.0f;
+	// Absolute schedule from the first send - waits never accumulate drift
+	const int64_t intervalUs = Options().IntervalMs() * 1000ll;
+	const auto schedule_start_us = ping_started_us;
 
+	// status holds the last probe failure - returned if nothing got through
 	for (uint16_t seq_num = 1; seq_num <= Options().Count(); ++seq_num)
 	{
-		// OutputLn("Sending echo request...");
-		if (!Send(ip4, sock_fd, seq_num))
-		{
-			ErrorLn("Failed to send", errno);
+		WaitToSend(schedule_start_us + (seq_num - 1) * intervalUs);
+		const IcmpEchoRequest request(seq_num);
+		status = Send(ip4, request);
+		if (!status)
 			break;
-		}
 		transmitted++;
-		// OutputLn("Receiving echo response...");
 		bool canContinue = false;
-		if (Receive(sock_fd, seq_num, times_ms[received], canContinue))
+		unsigned char reply[64];
+		uint16_t replyLen = 0u;
+		status = Receive(ICMP_ER, seq_num, ProbeTimeoutUs(_rtt), reply, sizeof(reply), replyLen,
+						 times_ms[received], canContinue);
+		if (status)
 		{
+			_rtt.AddSample(static_cast<uint32_t>(times_ms[received] * 1000.0f));
 			// Update statistics
 			// Mean and variance are computed in an incremental way
 			if (times_ms[received] < min_time_ms)
@@ -210,19 +280,21 @@ bool Esp32IcmpPing::CallPing(PingResults &result, Print *printer)
 			mean_total_ms += times_ms[received];
 			received++;
 		}
+		else if (status.Error() == PING_ERR_TIMEOUT)
+			_rtt.AddTimeout();
 		if (!canContinue)
 			break; //done
 
-		time_elapsed_ms = millis() - ping_started_time;
+		time_elapsed_ms = static_cast<unsigned int>((Transport().NowUs() - ping_started_us) / 1000);
 		if (time_elapsed_ms > Options().TotalTimeoutMs())
 		{
 			if (seq_num < Options().Count())
-				ErrorLn("Timed out overall");
+				status = Report<PING_LOG_LEVEL_WARN>(PING_ERR_TOTAL_TIMEOUT);
 			break;
 		}
 		yield(); // Allow other code to run
 	}
-	closesocket(sock_fd);
+	Transport().Close();
 
 	float mean_ms = received > 0u ? mean_total_ms / static_cast<float>(received) : 0.0f;
 	float var_total_ms = 0.0f;
@@ -234,39 +306,182 @@ bool Esp32IcmpPing::CallPing(PingResults &result, Print *printer)
 	float sd_ms = var_total_ms > 0.0f ? sqrt(var_total_ms / static_cast<float>(received)) : 0.0f;
 
 	result.SetResults(transmitted, received, 
-					static_cast<uint16_t>(time_elapsed_ms),
+					static_cast<uint32_t>(time_elapsed_ms),
 					min_time_ms, 
 					max_time_ms, 
 					mean_ms, 
 					sd_ms);
-	// Return true if at least one ping had a "pong"
-	return received > 0u;
+	// Ok if at least one ping had a "pong"
+	if (received > 0u)
+		return PingStatus();
+	return status ? PingStatus(PING_ERR_NO_REPLY) : status;
+}
+
+/// @brief
+/// @param result
+/// @param printer
+/// @return
+PingStatus Esp32IcmpPing::pingTimestamp(PingTimestampResults &result, Print *printer)
+{
+	result = PingTimestampResults();
+	if (_inPing)
+		return Report<PING_LOG_LEVEL_ERROR>(PING_ERR_ALREADY_IN_PING);
+	_inPing = true;
+	auto ret = CallTimestampPing(result, printer);
+	_inPing = false;
+	return ret;
+}
+
+/// @brief Difference of two times of day, wrapped into +/- half a day
+/// @param laterUs
+/// @param earlierUs
+/// @return
+static int64_t DayDiffUs(const int64_t laterUs, const int64_t earlierUs)
+{
+	constexpr int64_t dayUs = IcmpTimestampRequest::MS_PER_DAY * 1000ll;
+	auto diffUs = (laterUs - earlierUs) % dayUs;
+	if (diffUs > dayUs / 2)
+		diffUs -= dayUs;
+	else if (diffUs < -dayUs / 2)
+		diffUs += dayUs;
+	return diffUs;
 }
 
 /// @brief
+/// Each reply gives the forward leg plus the clock offset (receive - originate)
+/// and the reverse leg less it (our receive - transmit). The offset is taken
+/// from the fastest round trip, where queueing - and so asymmetry - is least.
+/// Our times come from the transport's clock, not UT; the offset absorbs that.
+/// @param result
 /// @param printer
-bool PingOptions::GetAddress(uint32_t &ip4, Print *printer) const
+/// @return
+PingStatus Esp32IcmpPing::CallTimestampPing(PingTimestampResults &result, Print *printer)
+{
+	uint32_t ip4 = 0u;
+	auto status = PrepareToPing(ip4, printer);
+	if (!status)
+		return status;
+	constexpr int64_t dayUs = IcmpTimestampRequest::MS_PER_DAY * 1000ll;
+	// Track data
+	uint8_t transmitted = 0u;
+	uint8_t received = 0u;
+	auto time_elapsed_ms = 0u;
+	const auto ping_started_us = Transport().NowUs();
+	// Legs include the clock offset until the end
+	int64_t min_rtt_us = INT64_MAX;
+	int64_t best_forward_us = 0;
+	int64_t best_reverse_us = 0;
+	int64_t min_forward_us = INT64_MAX;
+	int64_t min_reverse_us = INT64_MAX;
+	int64_t total_forward_us = 0;
+	int64_t total_reverse_us = 0;
+	const int64_t intervalUs = Options().IntervalMs() * 1000ll;
+	const auto schedule_start_us = ping_started_us;
+
+	// status holds the last probe failure - returned if nothing got through
+	for (uint16_t seq_num = 1; seq_num <= Options().Count(); ++seq_num)
+	{
+		WaitToSend(schedule_start_us + (seq_num - 1) * intervalUs);
+		const auto originate_us = Transport().NowUs();
+		const IcmpTimestampRequest request(seq_num, static_cast<uint32_t>((originate_us / 1000) % IcmpTimestampRequest::MS_PER_DAY));
+		status = Send(ip4, request);
+		if (!status)
+			break;
+		transmitted++;
+		bool canContinue = false;
+		unsigned char reply[64];
+		uint16_t replyLen = 0u;
+		float elapsed_ms = 0.0f;
+		status = Receive(ICMP_TSR, seq_num, ProbeTimeoutUs(_timestampRtt), reply, sizeof(reply), replyLen,
+						 elapsed_ms, canContinue);
+		if (status)
+		{
+			const auto arrived_us = Transport().NowUs();
+			_timestampRtt.AddSample(static_cast<uint32_t>(arrived_us - originate_us));
+			const IcmpTimestampResponse response(reply, replyLen);
+			if (response.IsStandard())
+			{
+				const auto forward_us = DayDiffUs(response.ReceiveMs() * 1000ll, originate_us % dayUs);
+				const auto reverse_us = DayDiffUs(arrived_us % dayUs, response.TransmitMs() * 1000ll);
+				// Excludes the time the target held the request
+				const auto rtt_us = forward_us + reverse_us;
+				if (rtt_us < min_rtt_us)
+				{
+					min_rtt_us = rtt_us;
+					best_forward_us = forward_us;
+					best_reverse_us = reverse_us;
+				}
+				if (forward_us < min_forward_us)
+					min_forward_us = forward_us;
+				if (reverse_us < min_reverse_us)
+					min_reverse_us = reverse_us;
+				total_forward_us += forward_us;
+				total_reverse_us += reverse_us;
+				received++;
+			}
+			else
+			{
+				_stats.AddInvalidReply();
+				status = Report<PING_LOG_LEVEL_WARN>(PING_ERR_INVALID_RESPONSE);
+			}
+		}
+		else if (status.Error() == PING_ERR_TIMEOUT)
+			_timestampRtt.AddTimeout();
+		if (!canContinue)
+			break; //done
+
+		time_elapsed_ms = static_cast<unsigned int>((Transport().NowUs() - ping_started_us) / 1000);
+		if (time_elapsed_ms > Options().TotalTimeoutMs())
+		{
+			if (seq_num < Options().Count())
+				status = Report<PING_LOG_LEVEL_WARN>(PING_ERR_TOTAL_TIMEOUT);
+			break;
+		}
+		yield(); // Allow other code to run
+	}
+	Transport().Close();
+
+	if (received > 0u)
+	{
+		const auto offset_us = (best_forward_us - best_reverse_us) / 2;
+		// Whole micro seconds, as the minimums - so a mean never rounds below its minimum
+		const int64_t mean_forward_us = total_forward_us / received;
+		const int64_t mean_reverse_us = total_reverse_us / received;
+		result.SetResults(transmitted, received,
+						  static_cast<uint32_t>(time_elapsed_ms),
+						  offset_us / 1000.0f,
+						  min_rtt_us / 1000.0f,
+						  (min_forward_us - offset_us) / 1000.0f,
+						  (mean_forward_us - offset_us) / 1000.0f,
+						  (min_reverse_us + offset_us) / 1000.0f,
+						  (mean_reverse_us + offset_us) / 1000.0f);
+		return PingStatus();
+	}
+	result.SetResults(transmitted, received, static_cast<uint32_t>(time_elapsed_ms),
+					  0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+	return status ? PingStatus(PING_ERR_NO_REPLY) : status;
+}
+
+/// @brief
+/// @param ip4
+/// @return
+PingStatus PingOptions::GetAddress(uint32_t &ip4) const
 {
 	ip4 = 0u;
 	if (_host.length() > 0)
 	{
 		IPAddress remote_addr;
 		if (!WiFi.hostByName(_host.c_str(), remote_addr))
-		{
-			if (printer != nullptr)
-				printer->printf("Cannot resolve host: <%s>\r\n", _host.c_str());
-			return false;
-		}
+			return PingStatus(PING_ERR_RESOLVE_FAILED);
 		ip4 = (uint32_t)remote_addr;
 	}
 	else if (_ip4 != 0u)
 	{
 		ip4 = _ip4;
 	}
-	else if (printer != nullptr)
-		printer->println("No address set");
-
-	return ip4 != 0u;
+	if (ip4 != 0u)
+		return PingStatus();
+	return PingStatus(PING_ERR_NO_ADDRESS);
 }
 
 /// @brief
@@ -290,6 +505,8 @@ void PingOptions::PrintState(Print *printer) const
 	printer->printf("Count: %u\r\n", (unsigned int)Count());
 	printer->printf("Timeout Recv: %u ms\r\n", (unsigned int)ReceiveTimeoutMs());
 	printer->printf("Timeout Total: %u ms\r\n", (unsigned int)TotalTimeoutMs());
+	if (IsAdaptiveTimeout())
+		printer->printf("Timeout Adaptive: %u - %u ms\r\n", (unsigned int)AdaptiveMinTimeoutMs(), (unsigned int)ReceiveTimeoutMs());
 }
 
 /// @brief
@@ -327,4 +544,58 @@ String PingResults::ResultString(bool includeTimes) const
 			  (unsigned int)StdDevTimeMs());
 	s += sf.c_str();
 	return s;
-}
\ No newline at end of file
+}
+
+/// @brief
+/// @param printer
+void PingTimestampResults::PrintState(Print *printer) const
+{
+	if (printer == nullptr)
+		return;
+	printer->print(ResultString());
+	printer->printf("Min round trip time %.2f ms\r\n", MinRttMs());
+	printer->printf("Clock offset %.2f ms\r\n", ClockOffsetMs());
+	printer->printf("Min forward time %.2f ms\r\n", MinForwardMs());
+	printer->printf("Ave. forward time %.2f ms\r\n", AveForwardMs());
+	printer->printf("Min reverse time %.2f ms\r\n", MinReverseMs());
+	printer->printf("Ave. reverse time %.2f ms\r\n", AveReverseMs());
+	printer->printf("Total time taken %u ms\r\n", (unsigned int)TotalTimeMs());
+}
+
+/// @brief
+/// @return
+String PingTimestampResults::ResultString() const
+{
+	FixedString<128> sf;
+	sf.format("Timestamps: Sent = %u, Received = %u, Forward = %dms, Reverse = %dms\n",
+			  (unsigned int)Transmitted(),
+			  (unsigned int)Received(),
+			  (int)AveForwardMs(),
+			  (int)AveReverseMs());
+	return String(sf.c_str());
+}
+
+/// @brief
+/// @param error
+/// @return
+const char *PingErrorString(const PingError error)
+{
+	static const char *const errorStrings[PING_ERR_COUNT] = {
+		"Ok",
+		"Already in Ping!",
+		"Invalid Options",
+		"No address set",
+		"Cannot resolve host",
+		"Failed to create socket",
+		"Failed to send",
+		"Timed out",
+		"Bad receive",
+		"Connection closed",
+		"Response too small",
+		"Invalid response",
+		"Bad time calc",
+		"Timed out overall",
+		"No reply",
+	};
+	return error < PING_ERR_COUNT ? errorStrings[error] : "Unknown error";
+}
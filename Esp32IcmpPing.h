@@ -19,6 +19,15 @@
 #include <Arduino.h>
 #include <cstdint>
 
+#include "IcmpTransport.h"
+#include "LwipIcmpTransport.h"
+#include "PingLog.h"
+#include "PingStats.h"
+#include "PingStatus.h"
+#include "RttEstimator.h"
+
+class IcmpPacket;
+
 /// <summary>
 /// The ICMP Ping Options
 /// </summary>
@@ -29,7 +38,9 @@ public:
 	constexpr static uint8_t MAX_COUNT = 10; // No more than 10 calls
 	constexpr static uint16_t DEFAULT_RECV_TIMEOUT_MS = 1000;
 	constexpr static uint16_t DEFAULT_TOTAL_TIMEOUT_MS = 0; // None - will be calculated
+	constexpr static uint16_t DEFAULT_INTERVAL_MS = 0;		// Next probe as soon as the last one is done
 	constexpr static uint16_t FIXED_MESSAGE_BYTE_COUNT = 32;
+	constexpr static uint16_t DEFAULT_ADAPTIVE_MIN_TIMEOUT_MS = 50; // Allow for WiFi power save latency
 
 private:
 	String _host;			  // Host string - either this or _ip must be valid
@@ -37,10 +48,15 @@ private:
 	uint8_t _count;			  // How many times to ping the target address
 	uint16_t _recvTimeoutMs;  // Socket receive tiemout per call
 	uint16_t _totalTimeoutMs; // Drop out after this time even if not finished
+	uint16_t _adaptiveMinTimeoutMs; // 0 - fixed receive timeout, otherwise lower clamp on the adaptive one
+	uint16_t _intervalMs;			// Time from one probe's send to the next
 private:
 	/// @brief Calc timeout total from other fields
 	/// @return
-	uint32_t CalcTotalTimeoutMs() const { return Count() * ReceiveTimeoutMs(); }
+	uint32_t CalcTotalTimeoutMs() const
+	{
+		return Count() * static_cast<uint32_t>(IntervalMs() > ReceiveTimeoutMs() ? IntervalMs() : ReceiveTimeoutMs());
+	}
 	/// @brief
 	/// @param ip4
 	/// @param cnt
@@ -55,7 +71,9 @@ private:
 		  _host(host),
 		  _count(cnt > MAX_COUNT ? MAX_COUNT : cnt),
 		  _recvTimeoutMs(recvTimeoutMs > 0 ? recvTimeoutMs : DEFAULT_RECV_TIMEOUT_MS),
-		  _totalTimeoutMs(totalTimeoutMs)
+		  _totalTimeoutMs(totalTimeoutMs),
+		  _adaptiveMinTimeoutMs(0u),
+		  _intervalMs(DEFAULT_INTERVAL_MS)
 	{
 	}
 
@@ -81,7 +99,10 @@ public:
 	}
 
 public:
-	bool GetAddress(uint32_t &ip4, Print *printer = nullptr) const;
+	/// @brief Resolve the host name if set, otherwise the address
+	/// @param ip4 Network order
+	/// @return PING_ERR_RESOLVE_FAILED or PING_ERR_NO_ADDRESS - reported by the caller
+	PingStatus GetAddress(uint32_t &ip4) const;
 	uint8_t Count() const { return _count; }
 	uint16_t ReceiveTimeoutMs() const { return _recvTimeoutMs; }
 
@@ -92,6 +113,25 @@ public:
 		return _totalTimeoutMs == 0 ? CalcTotalTimeoutMs() : _totalTimeoutMs;
 	}
 
+	/// @brief Adaptive mode derives each probe's receive timeout from the target's measured RTT,
+	/// clamped between AdaptiveMinTimeoutMs() and ReceiveTimeoutMs()
+	/// @return
+	bool IsAdaptiveTimeout() const { return _adaptiveMinTimeoutMs > 0u; }
+	uint16_t AdaptiveMinTimeoutMs() const { return _adaptiveMinTimeoutMs; }
+
+	/// @brief
+	/// @param minTimeoutMs 0 to go back to the fixed receive timeout
+	void SetAdaptiveTimeout(const uint16_t minTimeoutMs = DEFAULT_ADAPTIVE_MIN_TIMEOUT_MS)
+	{
+		_adaptiveMinTimeoutMs = minTimeoutMs > ReceiveTimeoutMs() ? ReceiveTimeoutMs() : minTimeoutMs;
+	}
+
+	/// @brief Probes are sent on a fixed schedule, IntervalMs() apart from the first one.
+	/// A probe still waiting for its reply delays the next, without shifting the ones after.
+	/// @return 0 if probes go back to back
+	uint16_t IntervalMs() const { return _intervalMs; }
+	void SetInterval(const uint16_t intervalMs) { _intervalMs = intervalMs; }
+
 	/// @brief
 	/// @return
 	bool IsValid() const
@@ -115,7 +155,7 @@ class PingResults
 private:
 	uint8_t _transmitted_count;
 	uint8_t _received_count;
-	uint16_t _total_timeMs;
+	uint32_t _total_timeMs; // Can pass 65 s with a long interval
 	float _min_timeMs;
 	float _max_timeMs;
 	float _avg_timeMs;
@@ -144,7 +184,7 @@ public:
 			return 0.0f;
 		return static_cast<float>(TimeoutCount()) / Transmitted() * 100.0f;
 	}
-	uint16_t TotalTimeMs() const { return _total_timeMs; }
+	uint32_t TotalTimeMs() const { return _total_timeMs; }
 	float MinTimeMs() const { return _min_timeMs; }
 	float MaxTimeMs() const { return _max_timeMs; }
 	float AveTimeMs() const { return _avg_timeMs; }
@@ -170,7 +210,7 @@ public:
 	/// @param varMs
 	void SetResults(
 		const uint8_t transmitted, const uint8_t received,
-		const uint16_t totalMs,
+		const uint32_t totalMs,
 		const float minMs, const float maxMs,
 		const float meanMs, const float sdMs)
 	{
@@ -192,6 +232,91 @@ public:
 	String ResultString(bool includeTimes = false) const;
 };
 
+/// <summary>
+/// The ICMP Timestamp Results - one way delays.
+/// The target's clock offset is estimated from the sample with the lowest RTT, taking both
+/// directions of that sample as equal. The forward and reverse delays of every sample follow from it,
+/// so a rise above the minimum shows which way the queueing is. Target times are whole milli seconds.
+/// </summary>
+class PingTimestampResults
+{
+private:
+	uint8_t _transmitted_count;
+	uint8_t _received_count;
+	uint32_t _total_timeMs;
+	float _offsetMs; // Target clock less ours
+	float _min_rttMs;
+	float _min_forwardMs;
+	float _avg_forwardMs;
+	float _min_reverseMs;
+	float _avg_reverseMs;
+
+public:
+	/// @brief
+	explicit PingTimestampResults()
+		: _transmitted_count(0u), _received_count(0u), _total_timeMs(0u),
+		  _offsetMs(0.0f), _min_rttMs(0.0f),
+		  _min_forwardMs(0.0f), _avg_forwardMs(0.0f),
+		  _min_reverseMs(0.0f), _avg_reverseMs(0.0f) {}
+
+public:
+	uint16_t Transmitted() const { return _transmitted_count; }
+	uint16_t Received() const { return _received_count; }
+	uint32_t TotalTimeMs() const { return _total_timeMs; }
+	float ClockOffsetMs() const { return _offsetMs; }
+	float MinRttMs() const { return _min_rttMs; }
+	float MinForwardMs() const { return _min_forwardMs; }
+	float AveForwardMs() const { return _avg_forwardMs; }
+	float MinReverseMs() const { return _min_reverseMs; }
+	float AveReverseMs() const { return _avg_reverseMs; }
+
+	/// @brief
+	/// @return
+	bool IsValid() const
+	{
+		return Transmitted() >= Received() &&
+			   Received() > 0u &&
+			   AveForwardMs() >= MinForwardMs() &&
+			   AveReverseMs() >= MinReverseMs();
+	}
+
+	/// @brief
+	/// @param transmitted
+	/// @param received
+	/// @param totalMs
+	/// @param offsetMs
+	/// @param minRttMs
+	/// @param minForwardMs
+	/// @param aveForwardMs
+	/// @param minReverseMs
+	/// @param aveReverseMs
+	void SetResults(
+		const uint8_t transmitted, const uint8_t received,
+		const uint32_t totalMs,
+		const float offsetMs, const float minRttMs,
+		const float minForwardMs, const float aveForwardMs,
+		const float minReverseMs, const float aveReverseMs)
+	{
+		_transmitted_count = transmitted;
+		_received_count = received;
+		_total_timeMs = totalMs;
+		_offsetMs = offsetMs;
+		_min_rttMs = minRttMs;
+		_min_forwardMs = minForwardMs;
+		_avg_forwardMs = aveForwardMs;
+		_min_reverseMs = minReverseMs;
+		_avg_reverseMs = aveReverseMs;
+	}
+
+	/// @brief
+	/// @param
+	void PrintState(Print *) const;
+
+	/// @brief
+	/// @return
+	String ResultString() const;
+};
+
 /// <summary>
 ///
 /// </summary>
@@ -200,54 +325,89 @@ class Esp32IcmpPing
 private:
 	PingOptions _pingOptions;
 	Print *_printer;
+	PingLogHandler _logHandler;
+	void *_logContext;
 	bool _inPing;
+	PingStats _stats;
+	RttEstimator _rtt;			// Kept across calls to ping()
+	RttEstimator _timestampRtt; // Kept across calls to pingTimestamp() - targets answer these on a slower path
+	LwipIcmpTransport _lwipTransport;
+	IcmpTransport *_transport; // nullptr - use _lwipTransport
 
 private:
-	/// @brief Optional Message/Error handling
-	/// @param str
-	void OutputLn(const char *str)
-	{
-		if (_printer != nullptr)
-			_printer->println(str);
-	}
-	bool ErrorLn(const char *str)
+	/// @brief Pass the status to the log handler (or printer) if Level is compiled in
+	/// @param status
+	/// @return status - so failures can be reported and returned in one go
+	template <uint8_t Level>
+	PingStatus Report(const PingStatus &status)
 	{
-		OutputLn(str);
-		return false;
+		if (Level != PING_LOG_LEVEL_NONE && Level <= PING_LOG_LEVEL)
+			Log(Level, status);
+		return status;
 	}
-	bool ErrorLn(const char *str, int errorNo);
+	void Log(uint8_t level, const PingStatus &status);
+
+	IcmpTransport &Transport() { return _transport != nullptr ? *_transport : _lwipTransport; }
 
 	/// @brief
-	/// @param sock_fd
 	/// @return
-	bool CreateAndSetUpSocket(int &sock_fd);
+	PingStatus CreateAndSetUpSocket();
+
+	/// @brief
+	/// @param rtt Estimates for the kind of probe being sent
+	/// @return The receive timeout for the next probe
+	uint32_t ProbeTimeoutUs(const RttEstimator &rtt) const;
+
+	/// @brief Hold the next probe for its slot in the schedule and the shared rate limit
+	/// @param deadlineUs Scheduled send time on the transport's clock
+	void WaitToSend(int64_t deadlineUs);
 
 	/// @brief
 	/// @param ip4
-	/// @param sock_fd
-	/// @param ping_seq_num
+	/// @param request Echo or timestamp request
 	/// @return
-	bool Send(uint32_t ip4, int sock_fd, uint16_t ping_seq_num);
+	PingStatus Send(uint32_t ip4, const IcmpPacket &request);
 
-	/// @brief
-	/// @param sock_fd
+	/// @brief Wait for the reply to ping_seq_num, discarding any other ICMP traffic
+	/// @param replyType ICMP_ER or ICMP_TSR
 	/// @param ping_seq_num
+	/// @param timeoutUs
+	/// @param reply Filled with the reply
+	/// @param replySize
+	/// @param replyLen
 	/// @param elapsed
+	/// @param canContinue false if the socket is no longer usable
+	/// @return
+	PingStatus Receive(uint8_t replyType, uint16_t ping_seq_num, uint32_t timeoutUs,
+					   unsigned char *reply, uint16_t replySize, uint16_t &replyLen,
+					   float &elapsed, bool &canContinue);
+
+	/// @brief Resolve, check the options and open the transport
+	/// @param ip4
+	/// @param printer
 	/// @return
-	bool Receive(int sock_fd, uint16_t ping_seq_num, float &elapsed, bool &timedOut);
+	PingStatus PrepareToPing(uint32_t &ip4, Print *printer);
 
 	/// @brief Do the Ping
 	/// @param result
 	/// @param printer
 	/// @return
-	bool CallPing(PingResults &result, Print *printer = nullptr);
+	PingStatus CallPing(PingResults &result, Print *printer = nullptr);
+
+	/// @brief Do the Timestamp Ping
+	/// @param result
+	/// @param printer
+	/// @return
+	PingStatus CallTimestampPing(PingTimestampResults &result, Print *printer = nullptr);
 
 public:
 	/// @brief
 	/// @param pingOptions
 	/// @param printer
 	explicit Esp32IcmpPing(const PingOptions &pingOptions, Print *printer = nullptr)
-		: _pingOptions(pingOptions), _printer(printer), _inPing(false) {}
+		: _pingOptions(pingOptions), _printer(printer),
+		  _logHandler(nullptr), _logContext(nullptr), _inPing(false),
+		  _transport(nullptr) {}
 
 	/// @brief
 	/// @param dest
@@ -276,17 +436,60 @@ public:
 public:
 	const PingOptions &Options() const { return _pingOptions; }
 
+	/// @brief
+	/// @param minTimeoutMs 0 to go back to the fixed receive timeout
+	void SetAdaptiveTimeout(const uint16_t minTimeoutMs = PingOptions::DEFAULT_ADAPTIVE_MIN_TIMEOUT_MS)
+	{
+		_pingOptions.SetAdaptiveTimeout(minTimeoutMs);
+	}
+	void SetInterval(const uint16_t intervalMs) { _pingOptions.SetInterval(intervalMs); }
+
+	/// @brief Send and receive through another transport, e.g. a SimulatedIcmpTransport
+	/// @param transport nullptr to go back to the lwIP socket. Must outlive its use here.
+	void SetTransport(IcmpTransport *transport) { _transport = transport; }
+
+	/// @brief RTT estimates for this target - drive the adaptive timeout
+	/// @return
+	const RttEstimator &Rtt() const { return _rtt; }
+	RttEstimator &Rtt() { return _rtt; }
+
+	/// @brief RTT estimates from timestamp probes - kept apart so they do not skew echo timeouts
+	/// @return
+	const RttEstimator &TimestampRtt() const { return _timestampRtt; }
+
+	/// @brief Snapshot of the counters accumulated since construction or the last reset
+	/// @return
+	PingStats Stats() const { return _stats; }
+	void ResetStats() { _stats.Reset(); }
+
+	/// @brief Replace the default printer output with a custom sink.
+	/// Only levels up to PING_LOG_LEVEL ever reach it.
+	/// @param handler nullptr to go back to the printer
+	/// @param context
+	void SetLogHandler(PingLogHandler handler, void *context = nullptr)
+	{
+		_logHandler = handler;
+		_logContext = context;
+	}
+
 	/// @brief Do the Ping
 	/// @param result
 	/// @param printer
-	/// @return
-	bool ping(PingResults &result, Print *printer = nullptr);
-	bool ping(Print *printer = nullptr)
+	/// @return PING_OK if at least one ping had a "pong", otherwise the last failure
+	PingStatus ping(PingResults &result, Print *printer = nullptr);
+	PingStatus ping(Print *printer = nullptr)
 	{
 		PingResults result;
-		if (!ping(result, printer))
-			return false;
-		result.PrintState(printer);
-		return true;
+		const auto status = ping(result, printer);
+		if (status)
+			result.PrintState(printer);
+		return status;
 	}
+
+	/// @brief Probe with ICMP Timestamp requests instead of Echo - same options, socket and pacing.
+	/// Not every host answers these.
+	/// @param result
+	/// @param printer
+	/// @return PING_OK if at least one timestamp reply came back, otherwise the last failure
+	PingStatus pingTimestamp(PingTimestampResults &result, Print *printer = nullptr);
 };
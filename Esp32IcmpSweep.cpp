@@ -0,0 +1,297 @@
+// (c) Copyright 2024 Fatlab Software Pty Ltd.
+//
+// ICMP Ping library for the ESP32
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110 - 1301  USA
+
+#include "Esp32IcmpSweep.h"
+#include "Esp32IcmpPing.h"
+#include "IcmpPacket.h"
+
+#include "lwip/sockets.h"
+
+#include <cmath>
+#include <cstdio>
+
+// More outstanding probes than the raw socket's receive mailbox holds
+// and replies arriving together get dropped by lwIP
+#if defined(DEFAULT_RAW_RECVMBOX_SIZE)
+constexpr static uint8_t raw_recv_mbox_size = DEFAULT_RAW_RECVMBOX_SIZE;
+#else
+constexpr static uint8_t raw_recv_mbox_size = Esp32IcmpSweep::DEFAULT_WINDOW;
+#endif
+
+/// @brief
+/// @param network4
+/// @param prefixLen
+/// @param window
+/// @param timeoutMs
+/// @param retries
+Esp32IcmpSweep::Esp32IcmpSweep(const uint32_t network4, const uint8_t prefixLen,
+							   const uint8_t window, const uint16_t timeoutMs, const uint8_t retries)
+	: _firstHost(0u), _hostCount(0u),
+	  _window(window > MAX_WINDOW ? MAX_WINDOW : window),
+	  _timeoutMs(timeoutMs), _retries(retries),
+	  _probed(0u), _alive(0u), _totalTimeMs(0u),
+	  _transport(nullptr)
+{
+	if (_window > raw_recv_mbox_size)
+		_window = raw_recv_mbox_size;
+	SetRange(network4, prefixLen);
+}
+
+/// @brief
+/// @param cidr
+/// @param window
+/// @param timeoutMs
+/// @param retries
+Esp32IcmpSweep::Esp32IcmpSweep(const char *cidr,
+							   const uint8_t window, const uint16_t timeoutMs, const uint8_t retries)
+	: Esp32IcmpSweep(0u, 0u, window, timeoutMs, retries)
+{
+	uint32_t network4 = 0u;
+	uint8_t prefixLen = 0u;
+	if (ParseCidr(cidr, network4, prefixLen))
+		SetRange(network4, prefixLen);
+}
+
+/// @brief
+/// @param cidr
+/// @param network4
+/// @param prefixLen
+/// @return
+bool Esp32IcmpSweep::ParseCidr(const char *cidr, uint32_t &network4, uint8_t &prefixLen)
+{
+	network4 = 0u;
+	prefixLen = 0u;
+	if (cidr == nullptr)
+		return false;
+	unsigned int a, b, c, d, len;
+	char tail;
+	if (sscanf(cidr, "%u.%u.%u.%u/%u%c", &a, &b, &c, &d, &len, &tail) != 5)
+		return false;
+	if (a > 255u || b > 255u || c > 255u || d > 255u || len > 32u)
+		return false;
+	network4 = htonl((a << 24) | (b << 16) | (c << 8) | d);
+	prefixLen = static_cast<uint8_t>(len);
+	return true;
+}
+
+/// @brief
+/// @param network4
+/// @param prefixLen
+void Esp32IcmpSweep::SetRange(const uint32_t network4, const uint8_t prefixLen)
+{
+	_firstHost = 0u;
+	_hostCount = 0u;
+	if (prefixLen < MIN_PREFIX_LEN || prefixLen > 32u || network4 == 0u)
+		return;
+	const uint32_t mask = prefixLen == 32u ? 0xFFFFFFFFu : ~(0xFFFFFFFFu >> prefixLen);
+	const uint32_t network = ntohl(network4) & mask;
+	const uint32_t size = (~mask) + 1u;
+	if (prefixLen >= 31u)
+	{
+		// Point to point - no network or broadcast address
+		_firstHost = network;
+		_hostCount = size;
+		return;
+	}
+	_firstHost = network + 1u;
+	_hostCount = size - 2u;
+}
+
+/// @brief
+/// @param seq
+/// @return
+uint32_t Esp32IcmpSweep::HostAddress(const uint16_t seq) const
+{
+	return htonl(_firstHost + seq - 1u);
+}
+
+/// @brief
+/// @param slot
+void Esp32IcmpSweep::Send(Slot &slot)
+{
+	const PingStats::PhaseTimer timer(_stats, Transport(), PingStats::PHASE_SEND);
+	slot.tries++;
+	const IcmpEchoRequest request(slot.seq, SWEEP_ID, slot.tries);
+	slot.retryDue = false;
+	slot.sentUs = Transport().NowUs();
+	const auto status = Transport().Send(HostAddress(slot.seq), request.Data(), request.Size());
+	if (!status)
+	{
+		_stats.AddError(status.ErrorNo());
+		return;
+	}
+	_stats.AddSent(request.Size());
+}
+
+/// @brief
+/// @param slots
+/// @param waitUs
+/// @param inFlight
+/// @param onAlive
+/// @param context
+/// @return
+PingStatus Esp32IcmpSweep::Receive(Slot *slots, const uint32_t waitUs, uint8_t &inFlight,
+								   SweepHostCallback onAlive, void *context)
+{
+	const PingStats::PhaseTimer timer(_stats, Transport(), PingStats::PHASE_RECEIVE);
+	constexpr mem_size_t min_echo_recv_byte_count = 64;
+	unsigned char echo_packet[min_echo_recv_byte_count];
+	uint16_t len = 0u;
+	uint32_t fromIp4 = 0u;
+	const auto status = Transport().Receive(echo_packet, sizeof(echo_packet), len, fromIp4, waitUs);
+	const auto nowUs = Transport().NowUs();
+	switch (status.Error())
+	{
+	case PING_OK:
+		break;
+	case PING_ERR_TIMEOUT:
+		return PingStatus(); // Nothing yet - the caller deals with timeouts
+	case PING_ERR_RESPONSE_TOO_SMALL:
+		_stats.AddInvalidReply();
+		return PingStatus();
+	default:
+		_stats.AddError(status.ErrorNo());
+		return status;
+	}
+	_stats.AddReceived(len);
+	const IcmpEchoResponse echoResponse(echo_packet, len);
+	if (!echoResponse.IsOurs(SWEEP_ID))
+	{
+		_stats.AddInvalidReply();
+		return PingStatus();
+	}
+	const auto seq = echoResponse.SeqNo();
+	for (auto i = 0u; i < _window; ++i)
+	{
+		auto &slot = slots[i];
+		if (slot.seq == 0u || slot.seq != seq)
+			continue;
+		const auto ip4 = HostAddress(seq);
+		if (fromIp4 != ip4)
+			break;
+		// Still proves the host is up, but a reply to an earlier try cannot be timed from slot.sentUs
+		const auto rttMs = echoResponse.Tag() == slot.tries ? static_cast<float>(nowUs - slot.sentUs) / 1000.0f : NAN;
+		slot.seq = 0u;
+		inFlight--;
+		_alive++;
+		if (onAlive != nullptr)
+			onAlive(ip4, rttMs, context);
+		return PingStatus();
+	}
+	// Duplicate, or answered after we gave up on it
+	_stats.AddLateReply();
+	return PingStatus();
+}
+
+/// @brief Take the rate limiter's token for the next send, keeping any reservation for later
+/// @param rateLimiter
+/// @param nowUs
+/// @param sendAtUs Reserved slot, -1 if none
+/// @return True if the send may go now
+static bool CanSend(PingRateLimiter &rateLimiter, const int64_t nowUs, int64_t &sendAtUs)
+{
+	if (sendAtUs < 0)
+		sendAtUs = rateLimiter.Reserve(nowUs);
+	if (sendAtUs > nowUs)
+		return false;
+	sendAtUs = -1;
+	return true;
+}
+
+/// @brief
+/// @param onAlive
+/// @param context
+/// @return
+PingStatus Esp32IcmpSweep::sweep(SweepHostCallback onAlive, void *context)
+{
+	_probed = 0u;
+	_alive = 0u;
+	_totalTimeMs = 0u;
+	if (!IsValid())
+		return PingStatus(PING_ERR_INVALID_OPTIONS);
+	PingStatus status;
+	{
+		const PingStats::PhaseTimer timer(_stats, Transport(), PingStats::PHASE_CREATE_SOCKET);
+		status = Transport().Open();
+	}
+	if (!status)
+	{
+		_stats.AddError(status.ErrorNo());
+		return status;
+	}
+	const int64_t timeoutUs = _timeoutMs * 1000ll;
+	const auto startUs = Transport().NowUs();
+	Slot slots[MAX_WINDOW];
+	memset(slots, 0, sizeof(slots));
+	uint8_t inFlight = 0u;
+	uint32_t nextHost = 0u;
+	int64_t sendAtUs = -1;
+	auto &rateLimiter = Transport().RateLimiter();
+	while (status && (nextHost < _hostCount || inFlight > 0u))
+	{
+		auto nowUs = Transport().NowUs();
+		// Expired probes - retry or give up on the host
+		for (auto i = 0u; i < _window; ++i)
+		{
+			auto &slot = slots[i];
+			if (slot.seq == 0u)
+				continue;
+			if (!slot.retryDue && nowUs - slot.sentUs >= timeoutUs)
+			{
+				_stats.AddTimeout();
+				if (slot.tries > _retries)
+				{
+					slot.seq = 0u;
+					inFlight--;
+					continue;
+				}
+				slot.retryDue = true;
+			}
+			if (slot.retryDue && CanSend(rateLimiter, nowUs, sendAtUs))
+				Send(slot);
+		}
+		// Top up the window
+		for (auto i = 0u; i < _window && nextHost < _hostCount; ++i)
+		{
+			auto &slot = slots[i];
+			if (slot.seq != 0u)
+				continue;
+			if (!CanSend(rateLimiter, nowUs, sendAtUs))
+				break;
+			slot.seq = static_cast<uint16_t>(++nextHost);
+			slot.tries = 0u;
+			inFlight++;
+			_probed++;
+			Send(slot);
+		}
+		if (inFlight == 0u && nextHost >= _hostCount)
+			break;
+		// Wait for replies until the next timeout or rate limiter slot
+		nowUs = Transport().NowUs();
+		auto wakeUs = sendAtUs >= 0 ? sendAtUs : nowUs + timeoutUs;
+		for (auto i = 0u; i < _window; ++i)
+		{
+			const auto &slot = slots[i];
+			if (slot.seq != 0u && !slot.retryDue && slot.sentUs + timeoutUs < wakeUs)
+				wakeUs = slot.sentUs + timeoutUs;
+		}
+		status = Receive(slots, static_cast<uint32_t>(wakeUs > nowUs ? wakeUs - nowUs : 0), inFlight, onAlive, context);
+	}
+	Transport().Close();
+	_totalTimeMs = static_cast<uint32_t>((Transport().NowUs() - startUs) / 1000);
+	return status;
+}
@@ -0,0 +1,151 @@
+// (c) Copyright 2024 Fatlab Software Pty Ltd.
+//
+// ICMP Ping library for the ESP32
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110 - 1301  USA
+#pragma once
+
+#include <cstdint>
+
+#include "IcmpTransport.h"
+#include "LwipIcmpTransport.h"
+#include "PingStats.h"
+#include "PingStatus.h"
+
+/// @brief Called as soon as a host answers
+/// @param ip4 Network order
+/// @param rttMs NAN if the reply was to an earlier try than the last one sent - its send time is not kept
+/// @param context As passed to sweep()
+typedef void (*SweepHostCallback)(uint32_t ip4, float rttMs, void *context);
+
+/// <summary>
+/// Find the live hosts in a CIDR range - keeps a bounded window of
+/// outstanding echo requests over one socket
+/// </summary>
+class Esp32IcmpSweep
+{
+public:
+	constexpr static uint8_t MIN_PREFIX_LEN = 16; // Seq numbers index the hosts - no more than a /16
+	constexpr static uint8_t DEFAULT_WINDOW = 6;	// lwIP raw socket receive mailbox on the ESP32
+	constexpr static uint8_t MAX_WINDOW = 16;		// Further capped by DEFAULT_RAW_RECVMBOX_SIZE if lwIP sets it
+	constexpr static uint16_t DEFAULT_TIMEOUT_MS = 500;
+	constexpr static uint8_t DEFAULT_RETRIES = 1;
+	constexpr static uint16_t SWEEP_ID = 0xABAC; // Echo ident - keeps sweep replies apart from Esp32IcmpPing's
+
+private:
+	/// @brief One outstanding probe
+	struct Slot
+	{
+		uint16_t seq; // Host index + 1, 0 - free
+		uint8_t tries; // Also the tag of the last request sent - tells its reply from a late one to an earlier try
+		bool retryDue; // Timed out - resend when the rate limiter allows
+		int64_t sentUs;
+	};
+
+private:
+	uint32_t _firstHost; // Host order
+	uint32_t _hostCount;
+	uint8_t _window;
+	uint16_t _timeoutMs;
+	uint8_t _retries;
+	// Last sweep
+	uint32_t _probed;
+	uint32_t _alive;
+	uint32_t _totalTimeMs;
+	PingStats _stats;
+	LwipIcmpTransport _lwipTransport;
+	IcmpTransport *_transport; // nullptr - use _lwipTransport
+
+private:
+	IcmpTransport &Transport() { return _transport != nullptr ? *_transport : _lwipTransport; }
+
+	/// @brief
+	/// @param network4 Network order
+	/// @param prefixLen
+	void SetRange(uint32_t network4, uint8_t prefixLen);
+
+	/// @brief A failed send (e.g. ENOMEM when lwIP runs short of pbufs) counts as a try
+	/// which times out - the sweep carries on
+	/// @param slot
+	void Send(Slot &slot);
+
+	/// @brief Wait for one reply and hand it to its slot
+	/// @param slots
+	/// @param waitUs
+	/// @param inFlight
+	/// @param onAlive
+	/// @param context
+	/// @return
+	PingStatus Receive(Slot *slots, uint32_t waitUs, uint8_t &inFlight,
+					   SweepHostCallback onAlive, void *context);
+
+	/// @brief Host order index to network order address
+	/// @param seq
+	/// @return
+	uint32_t HostAddress(uint16_t seq) const;
+
+public:
+	/// @brief
+	/// @param network4 Any address in the range, network order
+	/// @param prefixLen 16 - 32
+	/// @param window Outstanding probes at any one time
+	/// @param timeoutMs Per probe
+	/// @param retries Extra probes for hosts which do not answer
+	explicit Esp32IcmpSweep(uint32_t network4, uint8_t prefixLen,
+							uint8_t window = DEFAULT_WINDOW,
+							uint16_t timeoutMs = DEFAULT_TIMEOUT_MS,
+							uint8_t retries = DEFAULT_RETRIES);
+
+	/// @brief
+	/// @param cidr e.g. "192.168.1.0/24"
+	/// @param window
+	/// @param timeoutMs
+	/// @param retries
+	explicit Esp32IcmpSweep(const char *cidr,
+							uint8_t window = DEFAULT_WINDOW,
+							uint16_t timeoutMs = DEFAULT_TIMEOUT_MS,
+							uint8_t retries = DEFAULT_RETRIES);
+
+	/// @brief
+	/// @param cidr
+	/// @param network4 Network order
+	/// @param prefixLen
+	/// @return
+	static bool ParseCidr(const char *cidr, uint32_t &network4, uint8_t &prefixLen);
+
+public:
+	uint32_t HostCount() const { return _hostCount; }
+	uint8_t Window() const { return _window; }
+	uint16_t TimeoutMs() const { return _timeoutMs; }
+	uint8_t Retries() const { return _retries; }
+	bool IsValid() const { return _hostCount > 0u && _window > 0u && _timeoutMs > 0u; }
+
+	// Last sweep
+	uint32_t ProbedCount() const { return _probed; }
+	uint32_t AliveCount() const { return _alive; }
+	uint32_t TotalTimeMs() const { return _totalTimeMs; }
+
+	PingStats Stats() const { return _stats; }
+	void ResetStats() { _stats.Reset(); }
+
+	/// @brief Send and receive through another transport, e.g. a SimulatedIcmpTransport
+	/// @param transport nullptr to go back to the lwIP socket. Must outlive its use here.
+	void SetTransport(IcmpTransport *transport) { _transport = transport; }
+
+	/// @brief Probe every host in the range
+	/// @param onAlive Called for each host as it answers
+	/// @param context Passed to onAlive
+	/// @return PING_OK if the sweep ran, even if nothing answered or some sends failed
+	PingStatus sweep(SweepHostCallback onAlive, void *context = nullptr);
+};
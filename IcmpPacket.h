@@ -91,16 +91,21 @@ public:
 	//	+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
 	//	| Internet Header + 64 bits of Original Data Datagram           |
 	//	+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-	explicit IcmpEchoRequest(const uint16_t ping_seq_num)
+	/// @brief
+	/// @param ping_seq_num
+	/// @param ping_id
+	/// @param tag Sent as the first data byte and echoed back - e.g. which try of a seq number this is
+	explicit IcmpEchoRequest(const uint16_t ping_seq_num, const uint16_t ping_id = PING_ID, const uint8_t tag = 0u)
 		:IcmpPacket(_echo_data, echo_byte_count)
 	{
 		Zero();
 		ICMPH_TYPE_SET(Header(), ICMP_ECHO); //Echo request
-		Header()->id = PING_ID;
+		Header()->id = ping_id;
 		Header()->seqno = htons(ping_seq_num);
 		// fill the additional data buffer with some data
 		for (auto i = 0u; i < echo_data_byte_count; i++)
 			_echo_data[sizeof(icmp_echo_hdr) + i] = static_cast<unsigned char>(i);
+		_echo_data[sizeof(icmp_echo_hdr)] = tag;
 		Header()->chksum = inet_chksum(Data(), Size());
 	}
 };
@@ -119,12 +124,109 @@ public:
 	/// @param ping_seq_num 
 	/// @return 
 	bool IsValid(const uint16_t ping_seq_num)const
+	{
+		return IsOurs() && SeqNo() == ping_seq_num;
+	}
+	/// @brief An echo reply to one of our requests - whatever the seq number
+	/// @return 
+	bool IsOurs(const uint16_t ping_id = IcmpEchoRequest::PING_ID)const
 	{
 		return  Size() >= sizeof(icmp_echo_hdr) &&
 			Header()->type == ICMP_ER &&
 			Header()->code == 0u &&
-			Header()->id == IcmpEchoRequest::PING_ID &&
-			Header()->seqno == htons(ping_seq_num);
+			Header()->id == ping_id &&
+			inet_chksum(Data(), Size()) == 0u;
 	}
+	uint16_t SeqNo()const { return ntohs(Header()->seqno); }
+	/// @brief The request's tag, 0 if the reply carries no data
+	/// @return
+	uint8_t Tag()const { return Size() > sizeof(icmp_echo_hdr) ? Data()[sizeof(icmp_echo_hdr)] : 0u; }
 };
 
+// For TIMESTAMP packets the ident and seq number are followed by three
+// timestamps - milli seconds since midnight UT, network order.
+// The high bit is set if the sender could not give a standard time.
+class IcmpTimestampRequest : public IcmpPacket
+{
+public:
+	//8 + 12 == 20
+	constexpr static mem_size_t timestamp_byte_count = sizeof(icmp_echo_hdr) + 3 * sizeof(uint32_t);
+	constexpr static uint32_t MS_PER_DAY = 86400000ul;
+
+private:
+	unsigned char _timestamp_data[timestamp_byte_count];
+
+public:
+	//  ################################################################
+	//  ###################  ICMP HEADER - TIMESTAMP ###################
+	//  ################################################################
+	//	0                   1                   2                   3
+	//	0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+	//  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+	//	| Type          | Code          | Checksum                      |
+	//	+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+	//	| ident                         |         seq number            |
+	//	+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+	//	| Originate Timestamp                                           |
+	//	+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+	//	| Receive Timestamp                                             |
+	//	+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+	//	| Transmit Timestamp                                            |
+	//	+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+	explicit IcmpTimestampRequest(const uint16_t ping_seq_num, const uint32_t originateMs,
+								  const uint16_t ping_id = IcmpEchoRequest::PING_ID)
+		:IcmpPacket(_timestamp_data, timestamp_byte_count)
+	{
+		Zero();
+		ICMPH_TYPE_SET(Header(), ICMP_TS); //Timestamp request
+		Header()->id = ping_id;
+		Header()->seqno = htons(ping_seq_num);
+		const uint32_t originate = htonl(originateMs);
+		memcpy(_timestamp_data + sizeof(icmp_echo_hdr), &originate, sizeof(originate));
+		Header()->chksum = inet_chksum(Data(), Size());
+	}
+};
+
+class IcmpTimestampResponse : public IcmpPacket
+{
+private:
+	uint32_t Timestamp(const uint8_t i)const
+	{
+		uint32_t value;
+		memcpy(&value, Data() + sizeof(icmp_echo_hdr) + i * sizeof(uint32_t), sizeof(value));
+		return ntohl(value);
+	}
+
+public:
+	explicit IcmpTimestampResponse(unsigned char* data, const uint16_t size)
+		:IcmpPacket(data, size)
+	{
+	}
+	/// @brief 
+	/// @param ping_seq_num 
+	/// @return 
+	bool IsValid(const uint16_t ping_seq_num)const
+	{
+		return IsOurs() && SeqNo() == ping_seq_num;
+	}
+	/// @brief A timestamp reply to one of our requests - whatever the seq number
+	/// @return 
+	bool IsOurs(const uint16_t ping_id = IcmpEchoRequest::PING_ID)const
+	{
+		return  Size() >= IcmpTimestampRequest::timestamp_byte_count &&
+			Header()->type == ICMP_TSR &&
+			Header()->code == 0u &&
+			Header()->id == ping_id &&
+			inet_chksum(Data(), Size()) == 0u;
+	}
+	uint16_t SeqNo()const { return ntohs(Header()->seqno); }
+	uint32_t OriginateMs()const { return Timestamp(0); }
+	uint32_t ReceiveMs()const { return Timestamp(1); }
+	uint32_t TransmitMs()const { return Timestamp(2); }
+	/// @brief False if the target set the high bit - its times are not milli seconds since midnight
+	/// @return 
+	bool IsStandard()const
+	{
+		return (ReceiveMs() & 0x80000000ul) == 0u && (TransmitMs() & 0x80000000ul) == 0u;
+	}
+};
@@ -0,0 +1,67 @@
+// (c) Copyright 2024 Fatlab Software Pty Ltd.
+//
+// ICMP Ping library for the ESP32
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110 - 1301  USA
+#pragma once
+
+#include <cstdint>
+
+#include "PingRateLimiter.h"
+#include "PingStatus.h"
+
+/// <summary>
+/// Where ICMP messages go and come from, and the clock they are timed by.
+/// LwipIcmpTransport is the real network; SimulatedIcmpTransport runs on a virtual one.
+/// Messages are ICMP only - no IP header either way.
+/// </summary>
+class IcmpTransport
+{
+public:
+	virtual ~IcmpTransport() {}
+
+	/// @brief Get ready to send and receive
+	/// @return
+	virtual PingStatus Open() = 0;
+	virtual void Close() = 0;
+
+	/// @brief
+	/// @param ip4 Network order
+	/// @param data
+	/// @param size
+	/// @return
+	virtual PingStatus Send(uint32_t ip4, const unsigned char *data, uint16_t size) = 0;
+
+	/// @brief Wait for the next ICMP message - ours or not
+	/// @param buffer
+	/// @param bufferSize
+	/// @param len Bytes of ICMP message in buffer
+	/// @param fromIp4 Sender, network order
+	/// @param timeoutUs
+	/// @return PING_ERR_TIMEOUT if nothing arrived in time
+	virtual PingStatus Receive(unsigned char *buffer, uint16_t bufferSize,
+							   uint16_t &len, uint32_t &fromIp4, uint32_t timeoutUs) = 0;
+
+	/// @brief Monotonic clock
+	/// @return Micro seconds
+	virtual int64_t NowUs() = 0;
+
+	/// @brief Block until NowUs() reaches deadlineUs
+	/// @param deadlineUs
+	virtual void WaitUntilUs(int64_t deadlineUs) = 0;
+
+	/// @brief The probe rate limiter for NowUs()'s clock - shared by every transport on that clock
+	/// @return
+	virtual PingRateLimiter &RateLimiter() = 0;
+};
@@ -0,0 +1,141 @@
+// (c) Copyright 2024 Fatlab Software Pty Ltd.
+//
+// ICMP Ping library for the ESP32
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110 - 1301  USA
+
+#include "LwipIcmpTransport.h"
+#include <Arduino.h>
+
+#include "lwip/ip.h"
+#include "lwip/sockets.h"
+
+#include <esp_timer.h>
+
+/// @brief
+/// @return
+PingStatus LwipIcmpTransport::Open()
+{
+	Close();
+	_sock_fd = socket(AF_INET, SOCK_RAW, IPPROTO_ICMP);
+	if (_sock_fd < 0)
+		return PingStatus(PING_ERR_SOCKET_CREATE, errno);
+	return PingStatus();
+}
+
+/// @brief
+void LwipIcmpTransport::Close()
+{
+	if (_sock_fd < 0)
+		return;
+	closesocket(_sock_fd);
+	_sock_fd = -1;
+}
+
+/// @brief
+/// @param ip4
+/// @param data
+/// @param size
+/// @return
+PingStatus LwipIcmpTransport::Send(const uint32_t ip4, const unsigned char *data, const uint16_t size)
+{
+	// Target address
+	sockaddr_in to;
+	memset(&to, 0, sizeof(to));
+	to.sin_len = sizeof(to);
+	to.sin_family = AF_INET;
+	to.sin_addr.s_addr = ip4;
+	if (sendto(_sock_fd, data, size, 0, reinterpret_cast<sockaddr *>(&to), sizeof(to)) <= 0)
+		return PingStatus(PING_ERR_SEND_FAILED, errno);
+	return PingStatus();
+}
+
+/// @brief
+/// @param buffer
+/// @param bufferSize
+/// @param len
+/// @param fromIp4
+/// @param timeoutUs
+/// @return
+PingStatus LwipIcmpTransport::Receive(unsigned char *buffer, const uint16_t bufferSize,
+									  uint16_t &len, uint32_t &fromIp4, const uint32_t timeoutUs)
+{
+	// IP header (20 bytes, more with options) + the largest ICMP message we handle
+	constexpr mem_size_t recv_byte_count = 64 + sizeof(ip_hdr);
+	len = 0u;
+	fromIp4 = 0u;
+	fd_set readSet;
+	FD_ZERO(&readSet);
+	FD_SET(_sock_fd, &readSet);
+	timeval tout;
+	tout.tv_sec = timeoutUs / 1000000ul;
+	tout.tv_usec = timeoutUs % 1000000ul;
+	const auto ready = select(_sock_fd + 1, &readSet, nullptr, nullptr, &tout);
+	if (ready < 0)
+		return PingStatus(PING_ERR_RECEIVE_FAILED, errno);
+	if (ready == 0)
+		return PingStatus(PING_ERR_TIMEOUT);
+	// Recv
+	sockaddr_in from;
+	socklen_t from_len = sizeof(from);
+	unsigned char packet[recv_byte_count];
+	const auto recvLen = recvfrom(_sock_fd, packet, sizeof(packet), MSG_DONTWAIT,
+								  reinterpret_cast<sockaddr *>(&from), &from_len);
+	if (recvLen < 0)
+	{
+		const auto e = errno;
+		if (e == EAGAIN || e == EWOULDBLOCK)
+			return PingStatus(PING_ERR_TIMEOUT, e);
+		return PingStatus(PING_ERR_RECEIVE_FAILED, e);
+	}
+	if (recvLen == 0)
+		return PingStatus(PING_ERR_CONNECTION_CLOSED);
+	if (recvLen < static_cast<int>(sizeof(ip_hdr)))
+		return PingStatus(PING_ERR_RESPONSE_TOO_SMALL);
+	// Strip the IP header
+	const auto ipHeaderBytes = IPH_HL(reinterpret_cast<ip_hdr *>(packet)) * sizeof(uint32_t);
+	if (recvLen < static_cast<int>(ipHeaderBytes))
+		return PingStatus(PING_ERR_RESPONSE_TOO_SMALL);
+	len = static_cast<uint16_t>(recvLen - ipHeaderBytes);
+	if (len > bufferSize)
+		len = bufferSize;
+	memcpy(buffer, packet + ipHeaderBytes, len);
+	fromIp4 = from.sin_addr.s_addr;
+	return PingStatus();
+}
+
+/// @brief
+/// @return
+int64_t LwipIcmpTransport::NowUs()
+{
+	return esp_timer_get_time();
+}
+
+/// @brief
+/// @param deadlineUs
+void LwipIcmpTransport::WaitUntilUs(const int64_t deadlineUs)
+{
+	for (;;)
+	{
+		const auto nowUs = esp_timer_get_time();
+		if (nowUs >= deadlineUs)
+			return;
+		const auto remainingUs = deadlineUs - nowUs;
+		// Sleep whole ticks and spin out the last millisecond
+		if (remainingUs > 2000)
+			delay(static_cast<uint32_t>(remainingUs / 1000 - 1));
+		else
+			delayMicroseconds(static_cast<uint32_t>(remainingUs));
+	}
+}
@@ -0,0 +1,53 @@
+// (c) Copyright 2024 Fatlab Software Pty Ltd.
+//
+// ICMP Ping library for the ESP32
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110 - 1301  USA
+#pragma once
+
+#include "IcmpTransport.h"
+
+/// <summary>
+/// Raw lwIP ICMP socket, timed by esp_timer
+/// </summary>
+class LwipIcmpTransport : public IcmpTransport
+{
+private:
+	int _sock_fd;
+
+public:
+	/// @brief
+	explicit LwipIcmpTransport() : _sock_fd(-1) {}
+	~LwipIcmpTransport() override { Close(); }
+
+	// The socket is only open during a ping - copies start closed
+	LwipIcmpTransport(const LwipIcmpTransport &) : _sock_fd(-1) {}
+	LwipIcmpTransport &operator=(const LwipIcmpTransport &)
+	{
+		Close();
+		return *this;
+	}
+
+public:
+	bool IsOpen() const { return _sock_fd >= 0; }
+
+	PingStatus Open() override;
+	void Close() override;
+	PingStatus Send(uint32_t ip4, const unsigned char *data, uint16_t size) override;
+	PingStatus Receive(unsigned char *buffer, uint16_t bufferSize,
+					   uint16_t &len, uint32_t &fromIp4, uint32_t timeoutUs) override;
+	int64_t NowUs() override;
+	void WaitUntilUs(int64_t deadlineUs) override;
+	PingRateLimiter &RateLimiter() override { return PingRateLimiter::Shared(); }
+};
@@ -0,0 +1,37 @@
+// (c) Copyright 2024 Fatlab Software Pty Ltd.
+//
+// ICMP Ping library for the ESP32
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110 - 1301  USA
+#pragma once
+
+#include "PingStatus.h"
+
+// Log levels - anything above PING_LOG_LEVEL is compiled out
+#define PING_LOG_LEVEL_NONE 0
+#define PING_LOG_LEVEL_ERROR 1 // The ping could not run or was cut short
+#define PING_LOG_LEVEL_WARN 2  // A single probe failed (timeouts etc.) - on the hot path
+#define PING_LOG_LEVEL_INFO 3
+#define PING_LOG_LEVEL_DEBUG 4
+
+// Set with a build flag e.g. -DPING_LOG_LEVEL=PING_LOG_LEVEL_WARN
+#ifndef PING_LOG_LEVEL
+#define PING_LOG_LEVEL PING_LOG_LEVEL_ERROR
+#endif
+
+/// @brief Pluggable log sink
+/// @param level One of PING_LOG_LEVEL_xxx
+/// @param status
+/// @param context As passed when registering the handler
+typedef void (*PingLogHandler)(uint8_t level, const PingStatus &status, void *context);
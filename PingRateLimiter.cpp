@@ -0,0 +1,82 @@
+// (c) Copyright 2024 Fatlab Software Pty Ltd.
+//
+// ICMP Ping library for the ESP32
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110 - 1301  USA
+
+#include "PingRateLimiter.h"
+
+// Ping instances may run in different tasks, on either core - one lock for all limiters.
+// Off the device (SimulatedNetwork on a host) a standard mutex does the same job.
+#if defined(ARDUINO)
+#include <Arduino.h>
+
+static portMUX_TYPE rateLimiterMux = portMUX_INITIALIZER_UNLOCKED;
+static void Lock() { portENTER_CRITICAL(&rateLimiterMux); }
+static void Unlock() { portEXIT_CRITICAL(&rateLimiterMux); }
+#else
+#include <mutex>
+
+static std::mutex rateLimiterMutex;
+static void Lock() { rateLimiterMutex.lock(); }
+static void Unlock() { rateLimiterMutex.unlock(); }
+#endif
+
+/// @brief
+/// @return
+PingRateLimiter &PingRateLimiter::Shared()
+{
+	static PingRateLimiter shared;
+	return shared;
+}
+
+/// @brief
+/// @param probesPerSecond
+/// @param burst
+void PingRateLimiter::Configure(const uint16_t probesPerSecond, const uint16_t burst)
+{
+	Lock();
+	_probesPerSecond = probesPerSecond;
+	_burst = burst > 0u ? burst : 1u;
+	_theoreticalArrivalUs = 0;
+	Unlock();
+}
+
+/// @brief
+void PingRateLimiter::Reset()
+{
+	Lock();
+	_theoreticalArrivalUs = 0;
+	Unlock();
+}
+
+/// @brief
+/// @param nowUs
+/// @return
+int64_t PingRateLimiter::Reserve(const int64_t nowUs)
+{
+	Lock();
+	if (_probesPerSecond == 0u)
+	{
+		Unlock();
+		return nowUs;
+	}
+	const int64_t emissionUs = 1000000 / _probesPerSecond;
+	const int64_t toleranceUs = emissionUs * (_burst - 1);
+	const int64_t tat = _theoreticalArrivalUs > nowUs ? _theoreticalArrivalUs : nowUs;
+	const int64_t sendAtUs = tat - toleranceUs > nowUs ? tat - toleranceUs : nowUs;
+	_theoreticalArrivalUs = tat + emissionUs;
+	Unlock();
+	return sendAtUs;
+}
@@ -0,0 +1,63 @@
+// (c) Copyright 2024 Fatlab Software Pty Ltd.
+//
+// ICMP Ping library for the ESP32
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110 - 1301  USA
+#pragma once
+
+#include <cstdint>
+
+/// <summary>
+/// Token bucket limiting the probe rate of all ping instances together.
+/// Kept as a theoretical arrival time (GCRA) - the same limit as a bucket of
+/// Burst() tokens refilled at ProbesPerSecond(), without tracking fractional tokens.
+/// One per clock domain: Shared() for the real clock, and one in each SimulatedNetwork.
+/// Each IcmpTransport hands out the one for its clock.
+/// Disabled (no limit) until configured.
+/// </summary>
+class PingRateLimiter
+{
+private:
+	uint16_t _probesPerSecond;
+	uint16_t _burst;
+	int64_t _theoreticalArrivalUs;
+
+public:
+	/// @brief
+	explicit PingRateLimiter() : _probesPerSecond(0u), _burst(1u), _theoreticalArrivalUs(0) {}
+
+	PingRateLimiter(const PingRateLimiter &) = delete;
+	PingRateLimiter &operator=(const PingRateLimiter &) = delete;
+
+	/// @brief The limiter for the real clock - shared by every LwipIcmpTransport
+	/// @return
+	static PingRateLimiter &Shared();
+
+public:
+	/// @brief
+	/// @param probesPerSecond 0 to disable
+	/// @param burst Probes which may go back to back after an idle spell
+	void Configure(uint16_t probesPerSecond, uint16_t burst = 1);
+	bool IsEnabled() const { return _probesPerSecond > 0u; }
+	uint16_t ProbesPerSecond() const { return _probesPerSecond; }
+	uint16_t Burst() const { return _burst; }
+
+	/// @brief Refill the bucket, keeping the configuration - e.g. after restarting the clock it is timed by
+	void Reset();
+
+	/// @brief Take a token, reserving one ahead if the bucket is empty
+	/// @param nowUs Monotonic clock
+	/// @return When the caller may send - nowUs if a token was available
+	int64_t Reserve(int64_t nowUs);
+};
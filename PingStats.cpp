@@ -0,0 +1,119 @@
+// (c) Copyright 2024 Fatlab Software Pty Ltd.
+//
+// ICMP Ping library for the ESP32
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110 - 1301  USA
+
+#include "PingStats.h"
+#include <Arduino.h>
+
+/// @brief
+/// @param errorNo
+/// @return
+uint32_t PingStats::ErrnoCountFor(const int errorNo) const
+{
+	for (auto i = 0u; i < _errnoSlotsUsed; ++i)
+	{
+		if (_errnos[i].errorNo == errorNo)
+			return _errnos[i].count;
+	}
+	return 0u;
+}
+
+/// @brief Linear scan - only a handful of distinct errno values ever turn up
+/// @param errorNo
+void PingStats::AddError(const int errorNo)
+{
+	for (auto i = 0u; i < _errnoSlotsUsed; ++i)
+	{
+		if (_errnos[i].errorNo == errorNo)
+		{
+			_errnos[i].count++;
+			return;
+		}
+	}
+	if (_errnoSlotsUsed >= MAX_ERRNO_SLOTS)
+	{
+		_errnoOverflow++;
+		return;
+	}
+	_errnos[_errnoSlotsUsed++] = ErrnoCount{errorNo, 1u};
+}
+
+/// @brief Errno slots are merged by value - those which do not fit go to the overflow count
+/// @param other
+void PingStats::Add(const PingStats &other)
+{
+	for (auto i = 0u; i < PHASE_COUNT; ++i)
+	{
+		auto &p = _phases[i];
+		const auto &o = other._phases[i];
+		p.calls += o.calls;
+		p.totalMicros += o.totalMicros;
+		if (o.maxMicros > p.maxMicros)
+			p.maxMicros = o.maxMicros;
+	}
+	for (auto i = 0u; i < other._errnoSlotsUsed; ++i)
+	{
+		const auto &e = other._errnos[i];
+		auto j = 0u;
+		while (j < _errnoSlotsUsed && _errnos[j].errorNo != e.errorNo)
+			j++;
+		if (j < _errnoSlotsUsed)
+			_errnos[j].count += e.count;
+		else if (_errnoSlotsUsed < MAX_ERRNO_SLOTS)
+			_errnos[_errnoSlotsUsed++] = e;
+		else
+			_errnoOverflow += e.count;
+	}
+	_errnoOverflow += other._errnoOverflow;
+	_resolveFailures += other._resolveFailures;
+	_timeouts += other._timeouts;
+	_invalidReplies += other._invalidReplies;
+	_lateReplies += other._lateReplies;
+	_packetsSent += other._packetsSent;
+	_packetsReceived += other._packetsReceived;
+	_bytesSent += other._bytesSent;
+	_bytesReceived += other._bytesReceived;
+}
+
+/// @brief
+/// @param printer
+void PingStats::PrintState(Print *printer) const
+{
+	if (printer == nullptr)
+		return;
+	static const char *const phaseNames[PHASE_COUNT] = {"GetAddress", "CreateSocket", "Send", "Receive", "Pacing"};
+	for (auto i = 0u; i < PHASE_COUNT; ++i)
+	{
+		const auto &p = _phases[i];
+		printer->printf("%s: calls = %u, ave = %.1f us, max = %u us\r\n",
+						phaseNames[i],
+						(unsigned int)p.calls,
+						p.AveMicros(),
+						(unsigned int)p.maxMicros);
+	}
+	printer->printf("Packets: Sent = %u (%u bytes), Received = %u (%u bytes)\r\n",
+					(unsigned int)PacketsSent(), (unsigned int)BytesSent(),
+					(unsigned int)PacketsReceived(), (unsigned int)BytesReceived());
+	printer->printf("Timeouts = %u, Invalid replies = %u, Late replies = %u, Resolve failures = %u\r\n",
+					(unsigned int)Timeouts(),
+					(unsigned int)InvalidReplies(),
+					(unsigned int)LateReplies(),
+					(unsigned int)ResolveFailures());
+	for (auto i = 0u; i < _errnoSlotsUsed; ++i)
+		printer->printf("Error no %d: %u\r\n", _errnos[i].errorNo, (unsigned int)_errnos[i].count);
+	if (_errnoOverflow > 0u)
+		printer->printf("Error no (other): %u\r\n", (unsigned int)_errnoOverflow);
+}
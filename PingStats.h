@@ -0,0 +1,168 @@
+// (c) Copyright 2024 Fatlab Software Pty Ltd.
+//
+// ICMP Ping library for the ESP32
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110 - 1301  USA
+#pragma once
+
+#include <Arduino.h>
+#include <cstdint>
+
+#include "IcmpTransport.h"
+
+/// <summary>
+/// Built in counters and timing accumulators for the ping engine.
+/// Plain value type - copy it to take a snapshot.
+/// </summary>
+class PingStats
+{
+public:
+	/// @brief The timed steps of a ping
+	enum Phase : uint8_t
+	{
+		PHASE_GET_ADDRESS = 0,
+		PHASE_CREATE_SOCKET,
+		PHASE_SEND,
+		PHASE_RECEIVE,
+		PHASE_PACING, // Waiting for the probe interval or the rate limiter
+		PHASE_COUNT
+	};
+	constexpr static uint8_t MAX_ERRNO_SLOTS = 8; // Distinct errno values tracked
+
+	/// @brief Accumulated time for one phase
+	struct PhaseTiming
+	{
+		uint32_t calls;
+		uint32_t maxMicros;
+		uint64_t totalMicros;
+
+		float AveMicros() const
+		{
+			return calls > 0u ? static_cast<float>(totalMicros) / static_cast<float>(calls) : 0.0f;
+		}
+	};
+
+	/// @brief Count of failures for one errno value
+	struct ErrnoCount
+	{
+		int errorNo;
+		uint32_t count;
+	};
+
+private:
+	PhaseTiming _phases[PHASE_COUNT];
+	ErrnoCount _errnos[MAX_ERRNO_SLOTS];
+	uint8_t _errnoSlotsUsed;
+	uint32_t _errnoOverflow; // Errors whose errno did not fit in a slot
+	uint32_t _resolveFailures;
+	uint32_t _timeouts;
+	uint32_t _invalidReplies;
+	uint32_t _lateReplies; // Replies to an earlier probe which had already timed out
+	uint32_t _packetsSent;
+	uint32_t _packetsReceived;
+	uint32_t _bytesSent;
+	uint32_t _bytesReceived;
+
+public:
+	/// @brief
+	explicit PingStats() { Reset(); }
+
+	/// @brief Zero all counters
+	void Reset()
+	{
+		for (auto &p : _phases)
+			p = PhaseTiming{0u, 0u, 0u};
+		for (auto &e : _errnos)
+			e = ErrnoCount{0, 0u};
+		_errnoSlotsUsed = 0u;
+		_errnoOverflow = 0u;
+		_resolveFailures = 0u;
+		_timeouts = 0u;
+		_invalidReplies = 0u;
+		_lateReplies = 0u;
+		_packetsSent = 0u;
+		_packetsReceived = 0u;
+		_bytesSent = 0u;
+		_bytesReceived = 0u;
+	}
+
+public:
+	const PhaseTiming &Timing(const Phase phase) const { return _phases[phase < PHASE_COUNT ? phase : 0]; }
+	uint8_t ErrnoSlotsUsed() const { return _errnoSlotsUsed; }
+	const ErrnoCount &ErrnoSlot(const uint8_t i) const { return _errnos[i < MAX_ERRNO_SLOTS ? i : 0]; }
+	uint32_t ErrnoCountFor(int errorNo) const;
+	uint32_t ErrnoOverflow() const { return _errnoOverflow; }
+	uint32_t ResolveFailures() const { return _resolveFailures; }
+	uint32_t Timeouts() const { return _timeouts; }
+	uint32_t InvalidReplies() const { return _invalidReplies; }
+	uint32_t LateReplies() const { return _lateReplies; }
+	uint32_t PacketsSent() const { return _packetsSent; }
+	uint32_t PacketsReceived() const { return _packetsReceived; }
+	uint32_t BytesSent() const { return _bytesSent; }
+	uint32_t BytesReceived() const { return _bytesReceived; }
+
+public:
+	/// @brief Accumulate the time taken by one call of a phase
+	/// @param phase
+	/// @param elapsedMicros
+	void AddTiming(const Phase phase, const uint32_t elapsedMicros)
+	{
+		if (phase >= PHASE_COUNT)
+			return;
+		auto &p = _phases[phase];
+		p.calls++;
+		p.totalMicros += elapsedMicros;
+		if (elapsedMicros > p.maxMicros)
+			p.maxMicros = elapsedMicros;
+	}
+	void AddError(int errorNo);
+	/// @brief Fold in another instance's counters and timings
+	/// @param other
+	void Add(const PingStats &other);
+	void AddResolveFailure() { _resolveFailures++; }
+	void AddTimeout() { _timeouts++; }
+	void AddInvalidReply() { _invalidReplies++; }
+	void AddLateReply() { _lateReplies++; }
+	void AddSent(const uint32_t bytes)
+	{
+		_packetsSent++;
+		_bytesSent += bytes;
+	}
+	void AddReceived(const uint32_t bytes)
+	{
+		_packetsReceived++;
+		_bytesReceived += bytes;
+	}
+
+	/// @brief
+	/// @param
+	void PrintState(Print *) const;
+
+public:
+	/// @brief Adds its lifetime to a phase of the stats, timed by the transport's clock
+	/// so runs on a SimulatedNetwork give the same stats every time
+	class PhaseTimer
+	{
+	private:
+		PingStats &_stats;
+		IcmpTransport &_clock;
+		const Phase _phase;
+		const int64_t _beginUs;
+
+	public:
+		explicit PhaseTimer(PingStats &stats, IcmpTransport &clock, const Phase phase)
+			: _stats(stats), _clock(clock), _phase(phase), _beginUs(clock.NowUs()) {}
+		~PhaseTimer() { _stats.AddTiming(_phase, static_cast<uint32_t>(_clock.NowUs() - _beginUs)); }
+	};
+};
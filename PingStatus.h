@@ -0,0 +1,69 @@
+// (c) Copyright 2024 Fatlab Software Pty Ltd.
+//
+// ICMP Ping library for the ESP32
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110 - 1301  USA
+#pragma once
+
+#include <cstdint>
+
+/// @brief Outcome of a ping or one of its steps
+enum PingError : uint8_t
+{
+	PING_OK = 0,
+	PING_ERR_ALREADY_IN_PING,
+	PING_ERR_INVALID_OPTIONS,
+	PING_ERR_NO_ADDRESS,
+	PING_ERR_RESOLVE_FAILED,
+	PING_ERR_SOCKET_CREATE,
+	PING_ERR_SEND_FAILED,
+	PING_ERR_TIMEOUT,
+	PING_ERR_RECEIVE_FAILED,
+	PING_ERR_CONNECTION_CLOSED,
+	PING_ERR_RESPONSE_TOO_SMALL,
+	PING_ERR_INVALID_RESPONSE,
+	PING_ERR_BAD_TIME_CALC,
+	PING_ERR_TOTAL_TIMEOUT,
+	PING_ERR_NO_REPLY,
+	PING_ERR_COUNT
+};
+
+/// @brief Fixed text for an error - no formatting
+/// @param error
+/// @return
+const char *PingErrorString(PingError error);
+
+/// <summary>
+/// A typed error plus the errno captured when it happened (0 if none)
+/// </summary>
+class PingStatus
+{
+private:
+	PingError _error;
+	int _errorNo;
+
+public:
+	/// @brief
+	/// @param error
+	/// @param errorNo
+	PingStatus(const PingError error = PING_OK, const int errorNo = 0)
+		: _error(error), _errorNo(errorNo) {}
+
+public:
+	PingError Error() const { return _error; }
+	int ErrorNo() const { return _errorNo; }
+	bool IsOk() const { return _error == PING_OK; }
+	explicit operator bool() const { return IsOk(); }
+	const char *ToString() const { return PingErrorString(_error); }
+};
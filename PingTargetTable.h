@@ -0,0 +1,319 @@
+// (c) Copyright 2024 Fatlab Software Pty Ltd.
+//
+// ICMP Ping library for the ESP32
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110 - 1301  USA
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#include <WiFi.h>
+
+#include "Esp32IcmpPing.h"
+
+/// @brief Called with each target's results by PingAll()
+/// @param index Target
+/// @param status
+/// @param results
+/// @param context As passed to PingAll()
+typedef void (*PingTargetCallback)(uint16_t index, const PingStatus &status, const PingResults &results, void *context);
+
+/// <summary>
+/// Fixed size table of ping targets for monitoring long host lists without the heap.
+/// Host names are interned once each in a string arena (and resolved once each),
+/// addresses are packed and per target settings are kept structure of arrays.
+/// </summary>
+template <uint16_t MaxTargets, uint32_t ArenaBytes = MaxTargets * 16ul>
+class PingTargetTable
+{
+	static_assert(MaxTargets > 0u && MaxTargets < 0xFFFFu, "MaxTargets must be 1 - 65534");
+	static_assert(ArenaBytes > 0u, "ArenaBytes must not be 0");
+
+public:
+	constexpr static uint16_t NO_TARGET = 0xFFFFu;
+	constexpr static uint16_t NO_NAME = 0xFFFFu;
+
+private:
+	// Interned host names
+	char _arena[ArenaBytes];
+	uint32_t _arenaUsed;
+	uint16_t _nameCount;
+	uint32_t _nameHash[MaxTargets];
+	uint32_t _nameStart[MaxTargets];
+	uint32_t _nameIp4[MaxTargets]; // Resolved, 0 - not yet
+
+	// Targets
+	uint16_t _size;
+	uint16_t _name[MaxTargets]; // NO_NAME - use _ip4
+	uint32_t _ip4[MaxTargets];
+	uint8_t _count[MaxTargets];
+	uint16_t _recvTimeoutMs[MaxTargets];
+	uint16_t _adaptiveMinTimeoutMs[MaxTargets];
+	uint16_t _intervalMs[MaxTargets];
+	uint32_t _srttUs[MaxTargets];
+	uint32_t _rttVarUs[MaxTargets];
+	PingError _lastError[MaxTargets];
+
+	PingStats _stats; // All targets together
+
+private:
+	/// @brief FNV-1a
+	/// @param str
+	/// @return
+	static uint32_t Hash(const char *str)
+	{
+		uint32_t hash = 2166136261u;
+		while (*str != '\0')
+		{
+			hash ^= static_cast<uint8_t>(*str++);
+			hash *= 16777619u;
+		}
+		return hash;
+	}
+
+	/// @brief Find or add a host name
+	/// @param host
+	/// @return NO_NAME if the arena is full
+	uint16_t Intern(const char *host)
+	{
+		const auto hash = Hash(host);
+		for (uint16_t i = 0u; i < _nameCount; ++i)
+		{
+			if (_nameHash[i] == hash && strcmp(_arena + _nameStart[i], host) == 0)
+				return i;
+		}
+		const auto bytes = strlen(host) + 1u;
+		if (_nameCount >= MaxTargets || _arenaUsed + bytes > ArenaBytes)
+			return NO_NAME;
+		memcpy(_arena + _arenaUsed, host, bytes);
+		_nameHash[_nameCount] = hash;
+		_nameStart[_nameCount] = _arenaUsed;
+		_nameIp4[_nameCount] = 0u;
+		_arenaUsed += bytes;
+		return _nameCount++;
+	}
+
+	/// @brief
+	/// @param name
+	/// @param ip4
+	/// @param count
+	/// @param recvTimeoutMs
+	/// @param adaptiveMinTimeoutMs
+	/// @param intervalMs
+	/// @return
+	uint16_t AddTarget(const uint16_t name, const uint32_t ip4, const uint8_t count,
+					   const uint16_t recvTimeoutMs, const uint16_t adaptiveMinTimeoutMs,
+					   const uint16_t intervalMs)
+	{
+		const auto i = _size++;
+		_name[i] = name;
+		_ip4[i] = ip4;
+		_count[i] = count;
+		_recvTimeoutMs[i] = recvTimeoutMs;
+		_adaptiveMinTimeoutMs[i] = adaptiveMinTimeoutMs;
+		_intervalMs[i] = intervalMs;
+		_srttUs[i] = 0u;
+		_rttVarUs[i] = 0u;
+		_lastError[i] = PING_OK;
+		return i;
+	}
+
+	/// @brief Look up one host name
+	/// @param name
+	/// @return false if it could not be resolved
+	bool Resolve(const uint16_t name)
+	{
+		IPAddress remote_addr;
+		if (!WiFi.hostByName(_arena + _nameStart[name], remote_addr))
+		{
+			_stats.AddResolveFailure();
+			return false;
+		}
+		_nameIp4[name] = (uint32_t)remote_addr;
+		return true;
+	}
+
+	/// @brief
+	/// @param i
+	/// @param results
+	/// @param transport
+	/// @param resolve Look up the target's name if not yet resolved
+	/// @return
+	PingStatus PingTarget(const uint16_t i, PingResults &results, IcmpTransport *transport, const bool resolve)
+	{
+		results = PingResults();
+		if (i >= _size)
+			return PingStatus(PING_ERR_INVALID_OPTIONS);
+		if (Address(i) == 0u && resolve)
+			Resolve(_name[i]);
+		if (Address(i) == 0u)
+		{
+			_lastError[i] = PING_ERR_RESOLVE_FAILED;
+			return PingStatus(PING_ERR_RESOLVE_FAILED);
+		}
+		Esp32IcmpPing pinger(Options(i));
+		pinger.SetTransport(transport);
+		pinger.Rtt().Seed(_srttUs[i], _rttVarUs[i]);
+		const auto status = pinger.ping(results);
+		_srttUs[i] = pinger.Rtt().SmoothedRttUs();
+		_rttVarUs[i] = pinger.Rtt().RttVarianceUs();
+		_lastError[i] = status.Error();
+		_stats.Add(pinger.Stats());
+		return status;
+	}
+
+public:
+	/// @brief
+	explicit PingTargetTable() { Clear(); }
+
+	/// @brief Remove all targets and names
+	void Clear()
+	{
+		_arenaUsed = 0u;
+		_nameCount = 0u;
+		_size = 0u;
+	}
+
+	/// @brief
+	/// @param host
+	/// @param count
+	/// @param recvTimeoutMs
+	/// @param adaptiveMinTimeoutMs 0 for a fixed receive timeout
+	/// @param intervalMs
+	/// @return Index of the new target, NO_TARGET if the table or arena is full
+	uint16_t Add(const char *host,
+				 const uint8_t count = PingOptions::DEFAULT_COUNT,
+				 const uint16_t recvTimeoutMs = PingOptions::DEFAULT_RECV_TIMEOUT_MS,
+				 const uint16_t adaptiveMinTimeoutMs = 0u,
+				 const uint16_t intervalMs = PingOptions::DEFAULT_INTERVAL_MS)
+	{
+		if (host == nullptr || *host == '\0' || _size >= MaxTargets)
+			return NO_TARGET;
+		const auto name = Intern(host);
+		if (name == NO_NAME)
+			return NO_TARGET;
+		return AddTarget(name, 0u, count, recvTimeoutMs, adaptiveMinTimeoutMs, intervalMs);
+	}
+
+	/// @brief
+	/// @param ip4 Network order
+	/// @param count
+	/// @param recvTimeoutMs
+	/// @param adaptiveMinTimeoutMs 0 for a fixed receive timeout
+	/// @param intervalMs
+	/// @return Index of the new target, NO_TARGET if the table is full
+	uint16_t Add(const uint32_t ip4,
+				 const uint8_t count = PingOptions::DEFAULT_COUNT,
+				 const uint16_t recvTimeoutMs = PingOptions::DEFAULT_RECV_TIMEOUT_MS,
+				 const uint16_t adaptiveMinTimeoutMs = 0u,
+				 const uint16_t intervalMs = PingOptions::DEFAULT_INTERVAL_MS)
+	{
+		if (ip4 == 0u || _size >= MaxTargets)
+			return NO_TARGET;
+		return AddTarget(NO_NAME, ip4, count, recvTimeoutMs, adaptiveMinTimeoutMs, intervalMs);
+	}
+
+public:
+	uint16_t Size() const { return _size; }
+	constexpr static uint16_t Capacity() { return MaxTargets; }
+	uint16_t NameCount() const { return _nameCount; }
+	uint32_t ArenaUsed() const { return _arenaUsed; }
+
+	/// @brief
+	/// @param i
+	/// @return nullptr if the target was added by address
+	const char *Host(const uint16_t i) const
+	{
+		return i < _size && _name[i] != NO_NAME ? _arena + _nameStart[_name[i]] : nullptr;
+	}
+
+	/// @brief
+	/// @param i
+	/// @return Network order, 0 if not resolved yet
+	uint32_t Address(const uint16_t i) const
+	{
+		if (i >= _size)
+			return 0u;
+		return _name[i] != NO_NAME ? _nameIp4[_name[i]] : _ip4[i];
+	}
+	PingError LastError(const uint16_t i) const { return i < _size ? _lastError[i] : PING_ERR_INVALID_OPTIONS; }
+
+	/// @brief Counters and phase timings of every ping made through the table, plus its own failed look ups
+	/// @return
+	const PingStats &Stats() const { return _stats; }
+	void ResetStats() { _stats.Reset(); }
+
+	/// @brief The settings of a target - always by address so there is no heap use
+	/// @param i
+	/// @return
+	PingOptions Options(const uint16_t i) const
+	{
+		PingOptions options(Address(i), _count[i], _recvTimeoutMs[i]);
+		options.SetAdaptiveTimeout(_adaptiveMinTimeoutMs[i]);
+		options.SetInterval(_intervalMs[i]);
+		return options;
+	}
+
+public:
+	/// @brief Look up every host name not yet resolved - each name only once
+	/// @param force Look them all up again
+	/// @return Names which could not be resolved
+	uint16_t ResolveAll(const bool force = false)
+	{
+		uint16_t failed = 0u;
+		for (uint16_t n = 0u; n < _nameCount; ++n)
+		{
+			if (_nameIp4[n] != 0u && !force)
+				continue;
+			if (!Resolve(n))
+				failed++;
+		}
+		return failed;
+	}
+
+	/// @brief Ping one target, looking up its name first if need be.
+	/// Its RTT estimates are restored before and saved after, so adaptive timeouts carry over.
+	/// @param i
+	/// @param results
+	/// @param transport nullptr for the lwIP socket
+	/// @return
+	PingStatus Ping(const uint16_t i, PingResults &results, IcmpTransport *transport = nullptr)
+	{
+		return PingTarget(i, results, transport, true);
+	}
+
+	/// @brief Ping every target in table order
+	/// @param onResult Called after each target, may be nullptr
+	/// @param context Passed to onResult
+	/// @param transport nullptr for the lwIP socket
+	/// @return Targets which got at least one reply
+	uint16_t PingAll(PingTargetCallback onResult, void *context = nullptr, IcmpTransport *transport = nullptr)
+	{
+		// Each unresolved name is looked up once a pass - those which fail wait for the next
+		ResolveAll();
+		uint16_t alive = 0u;
+		PingResults results;
+		for (uint16_t i = 0u; i < _size; ++i)
+		{
+			const auto status = PingTarget(i, results, transport, false);
+			if (status)
+				alive++;
+			if (onResult != nullptr)
+				onResult(i, status, results, context);
+			yield(); // Allow other code to run
+		}
+		return alive;
+	}
+};
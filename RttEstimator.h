@@ -0,0 +1,107 @@
+// (c) Copyright 2024 Fatlab Software Pty Ltd.
+//
+// ICMP Ping library for the ESP32
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110 - 1301  USA
+#pragma once
+
+#include <cstdint>
+
+/// <summary>
+/// Smoothed RTT and RTT variance for one target, as TCP does it (RFC 6298):
+///   SRTT   = 7/8 SRTT + 1/8 R
+///   RTTVAR = 3/4 RTTVAR + 1/4 |SRTT - R|
+///   RTO    = SRTT + 4 RTTVAR, doubled for each timeout in a row
+/// All times in micro seconds.
+/// </summary>
+class RttEstimator
+{
+public:
+	constexpr static uint8_t MAX_BACKOFF_SHIFT = 6; // Never more than x64 - the max clamp applies anyway
+
+private:
+	uint32_t _srttUs;
+	uint32_t _rttVarUs;
+	uint8_t _backoffShift; // Timeouts in a row since the last good sample
+	bool _hasSample;
+
+public:
+	/// @brief
+	explicit RttEstimator() { Reset(); }
+
+	/// @brief Forget all history
+	void Reset()
+	{
+		_srttUs = 0u;
+		_rttVarUs = 0u;
+		_backoffShift = 0u;
+		_hasSample = false;
+	}
+
+	/// @brief Restore previously saved estimates
+	/// @param srttUs
+	/// @param rttVarUs
+	void Seed(const uint32_t srttUs, const uint32_t rttVarUs)
+	{
+		_srttUs = srttUs;
+		_rttVarUs = rttVarUs;
+		_backoffShift = 0u;
+		_hasSample = srttUs > 0u;
+	}
+
+public:
+	bool HasSample() const { return _hasSample; }
+	uint32_t SmoothedRttUs() const { return _srttUs; }
+	uint32_t RttVarianceUs() const { return _rttVarUs; }
+	uint8_t BackoffShift() const { return _backoffShift; }
+
+	/// @brief The receive timeout to use for the next probe
+	/// @param minUs
+	/// @param maxUs Also used until there is a first sample
+	/// @return
+	uint32_t TimeoutUs(const uint32_t minUs, const uint32_t maxUs) const
+	{
+		if (!_hasSample)
+			return maxUs;
+		uint64_t rto = static_cast<uint64_t>(_srttUs) + 4ull * _rttVarUs;
+		rto <<= _backoffShift;
+		if (rto < minUs)
+			return minUs;
+		return rto > maxUs ? maxUs : static_cast<uint32_t>(rto);
+	}
+
+	/// @brief A reply came back
+	/// @param rttUs
+	void AddSample(const uint32_t rttUs)
+	{
+		_backoffShift = 0u;
+		if (!_hasSample)
+		{
+			_srttUs = rttUs;
+			_rttVarUs = rttUs / 2u;
+			_hasSample = true;
+			return;
+		}
+		const uint32_t err = rttUs > _srttUs ? rttUs - _srttUs : _srttUs - rttUs;
+		_rttVarUs = _rttVarUs - _rttVarUs / 4u + err / 4u;
+		_srttUs = _srttUs - _srttUs / 8u + rttUs / 8u;
+	}
+
+	/// @brief A probe timed out - back off until the next good sample
+	void AddTimeout()
+	{
+		if (_backoffShift < MAX_BACKOFF_SHIFT)
+			_backoffShift++;
+	}
+};
@@ -0,0 +1,365 @@
+// (c) Copyright 2024 Fatlab Software Pty Ltd.
+//
+// ICMP Ping library for the ESP32
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110 - 1301  USA
+
+#include "SimulatedNetwork.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+
+// ICMP header fields - kept local so there is no lwIP dependency
+constexpr static uint8_t icmp_header_byte_count = 8;
+constexpr static uint8_t icmp_type_echo_reply = 0;
+constexpr static uint8_t icmp_type_echo = 8;
+constexpr static uint8_t icmp_type_timestamp = 13;
+constexpr static uint8_t icmp_type_timestamp_reply = 14;
+constexpr static uint8_t icmp_timestamp_byte_count = icmp_header_byte_count + 12;
+constexpr static int64_t ms_per_day = 86400000ll;
+
+/// @brief Internet checksum (RFC 1071) into bytes 2 and 3 of the message
+/// @param data
+/// @param len
+static void SetIcmpChecksum(unsigned char *data, const uint16_t len)
+{
+	data[2] = 0u;
+	data[3] = 0u;
+	uint32_t sum = 0u;
+	for (auto i = 0u; i + 1u < len; i += 2u)
+		sum += (static_cast<uint32_t>(data[i]) << 8) | data[i + 1u];
+	if (len & 1u)
+		sum += static_cast<uint32_t>(data[len - 1u]) << 8;
+	while (sum >> 16)
+		sum = (sum & 0xFFFFu) + (sum >> 16);
+	sum = ~sum & 0xFFFFu;
+	data[2] = static_cast<unsigned char>(sum >> 8);
+	data[3] = static_cast<unsigned char>(sum & 0xFFu);
+}
+
+/// @brief
+/// @param seed
+SimulatedNetwork::SimulatedNetwork(const uint64_t seed)
+	: _nowUs(0),
+	  _random(seed != 0u ? seed : 0x9E3779B97F4A7C15ull),
+	  _order(0u),
+	  _mailboxSize(DEFAULT_MAILBOX_SIZE),
+	  _defaultProfile(SimulatedLinkProfile::Default()),
+	  _counters{0u, 0u, 0u, 0u, 0u, 0u, 0u, 0u}
+{
+}
+
+/// @brief xorshift64*
+/// @return
+uint64_t SimulatedNetwork::NextRandom()
+{
+	_random ^= _random >> 12;
+	_random ^= _random << 25;
+	_random ^= _random >> 27;
+	return _random * 0x2545F4914F6CDD1Dull;
+}
+
+/// @brief
+/// @return 0.0 - 1.0 (exclusive)
+float SimulatedNetwork::RandomUnit()
+{
+	return static_cast<float>(NextRandom() >> 40) * (1.0f / 16777216.0f);
+}
+
+/// @brief
+/// @param profile
+/// @param baseUs
+/// @return
+uint32_t SimulatedNetwork::SampleDelayUs(const SimulatedLinkProfile &profile, const uint32_t baseUs)
+{
+	switch (profile.distribution)
+	{
+	case SimulatedLinkProfile::LATENCY_UNIFORM:
+		return baseUs + static_cast<uint32_t>(RandomUnit() * profile.jitterUs);
+	case SimulatedLinkProfile::LATENCY_EXPONENTIAL:
+		return baseUs + static_cast<uint32_t>(-std::log(1.0f - RandomUnit()) * profile.jitterUs);
+	default:
+		return baseUs;
+	}
+}
+
+/// @brief
+/// @param ip4
+/// @param profile
+void SimulatedNetwork::SetProfile(const uint32_t ip4, const SimulatedLinkProfile &profile)
+{
+	auto it = std::lower_bound(_profiles.begin(), _profiles.end(), ip4,
+							   [](const HostProfile &h, const uint32_t ip) { return h.ip4 < ip; });
+	if (it != _profiles.end() && it->ip4 == ip4)
+		it->profile = profile;
+	else
+		_profiles.insert(it, HostProfile{ip4, profile});
+}
+
+/// @brief
+/// @param ip4
+/// @return
+const SimulatedLinkProfile &SimulatedNetwork::Profile(const uint32_t ip4) const
+{
+	auto it = std::lower_bound(_profiles.begin(), _profiles.end(), ip4,
+							   [](const HostProfile &h, const uint32_t ip) { return h.ip4 < ip; });
+	if (it != _profiles.end() && it->ip4 == ip4)
+		return it->profile;
+	return _defaultProfile;
+}
+
+/// @brief Min heap on delivery time, then send order
+/// @param aUs
+/// @param aOrder
+/// @param bUs
+/// @param bOrder
+/// @return
+static bool DeliversAfter(const int64_t aUs, const uint64_t aOrder, const int64_t bUs, const uint64_t bOrder)
+{
+	return aUs != bUs ? aUs > bUs : aOrder > bOrder;
+}
+
+/// @brief
+/// @param message
+void SimulatedNetwork::Schedule(const Message &message)
+{
+	_inFlight.push_back(message);
+	std::push_heap(_inFlight.begin(), _inFlight.end(), [](const Message &a, const Message &b)
+				   { return DeliversAfter(a.deliverAtUs, a.order, b.deliverAtUs, b.order); });
+}
+
+/// @brief
+/// @param timeUs
+void SimulatedNetwork::AdvanceTo(const int64_t timeUs)
+{
+	while (!_inFlight.empty() && _inFlight.front().deliverAtUs <= timeUs)
+	{
+		std::pop_heap(_inFlight.begin(), _inFlight.end(), [](const Message &a, const Message &b)
+					  { return DeliversAfter(a.deliverAtUs, a.order, b.deliverAtUs, b.order); });
+		const Message message = _inFlight.back();
+		_inFlight.pop_back();
+		if (message.deliverAtUs > _nowUs)
+			_nowUs = message.deliverAtUs;
+		for (auto endpoint : _endpoints)
+		{
+			if (endpoint->Deliver(message.fromIp4, message.data, message.len))
+				_counters.delivered++;
+			else
+				_counters.overflowed++;
+		}
+	}
+	if (timeUs > _nowUs)
+		_nowUs = timeUs;
+}
+
+/// @brief Build the target's answer to a request - timestamps are stamped once the forward delay is known
+/// @param profile
+/// @param request
+/// @param size
+/// @param reply
+/// @return false if the target would not answer it
+bool SimulatedNetwork::Reply(const SimulatedLinkProfile &profile, const unsigned char *request, const uint16_t size, Message &reply) const
+{
+	if (size < icmp_header_byte_count || size > MAX_MESSAGE_BYTES)
+		return false;
+	if (request[1] != 0u)
+		return false;
+	if (request[0] == icmp_type_echo)
+	{
+		memcpy(reply.data, request, size);
+		reply.len = size;
+		reply.data[0] = icmp_type_echo_reply;
+	}
+	else if (request[0] == icmp_type_timestamp && profile.answersTimestamps && size >= icmp_timestamp_byte_count)
+	{
+		memcpy(reply.data, request, icmp_timestamp_byte_count);
+		reply.len = icmp_timestamp_byte_count;
+		reply.data[0] = icmp_type_timestamp_reply;
+	}
+	else
+		return false;
+	SetIcmpChecksum(reply.data, reply.len);
+	return true;
+}
+
+/// @brief Receive and transmit times - ms since the target's midnight, sent back straight away
+/// @param profile
+/// @param arrivedUs When the request reached the target on the virtual clock
+/// @param reply
+void SimulatedNetwork::StampTimestampReply(const SimulatedLinkProfile &profile, const int64_t arrivedUs, Message &reply)
+{
+	auto ms = (arrivedUs / 1000 + profile.clockOffsetMs) % ms_per_day;
+	if (ms < 0)
+		ms += ms_per_day;
+	for (uint8_t i = 1; i <= 2; ++i)
+	{
+		unsigned char *field = reply.data + icmp_header_byte_count + i * 4u;
+		field[0] = static_cast<unsigned char>(ms >> 24);
+		field[1] = static_cast<unsigned char>(ms >> 16);
+		field[2] = static_cast<unsigned char>(ms >> 8);
+		field[3] = static_cast<unsigned char>(ms);
+	}
+	SetIcmpChecksum(reply.data, reply.len);
+}
+
+/// @brief
+/// @param ip4
+/// @param data
+/// @param size
+void SimulatedNetwork::Transmit(const uint32_t ip4, const unsigned char *data, const uint16_t size)
+{
+	_counters.sent++;
+	const auto &profile = Profile(ip4);
+	if (!profile.alive)
+		return;
+	Message reply;
+	if (!Reply(profile, data, size, reply))
+		return;
+	// Request lost on the way there, or reply on the way back
+	if (Chance(profile.lossRate) || Chance(profile.lossRate))
+	{
+		_counters.lost++;
+		return;
+	}
+	_counters.answered++;
+	reply.fromIp4 = ip4;
+	const int64_t forwardUs = SampleDelayUs(profile, profile.forwardDelayUs);
+	int64_t delayUs = forwardUs + SampleDelayUs(profile, profile.reverseDelayUs);
+	if (reply.data[0] == icmp_type_timestamp_reply)
+		StampTimestampReply(profile, _nowUs + forwardUs, reply);
+	if (Chance(profile.reorderRate))
+	{
+		_counters.reordered++;
+		delayUs += profile.reorderDelayUs;
+	}
+	if (Chance(profile.corruptRate))
+	{
+		_counters.corrupted++;
+		const auto bit = static_cast<uint32_t>(RandomUnit() * reply.len * 8u);
+		reply.data[bit / 8u] ^= static_cast<unsigned char>(1u << (bit % 8u));
+	}
+	reply.deliverAtUs = _nowUs + delayUs;
+	reply.order = _order++;
+	Schedule(reply);
+	if (Chance(profile.duplicateRate))
+	{
+		_counters.duplicated++;
+		reply.deliverAtUs += SampleDelayUs(profile, 1u);
+		reply.order = _order++;
+		Schedule(reply);
+	}
+}
+
+/// @brief
+/// @param endpoint
+void SimulatedNetwork::Attach(SimulatedIcmpTransport *endpoint)
+{
+	if (std::find(_endpoints.begin(), _endpoints.end(), endpoint) == _endpoints.end())
+		_endpoints.push_back(endpoint);
+}
+
+/// @brief
+/// @param endpoint
+void SimulatedNetwork::Detach(SimulatedIcmpTransport *endpoint)
+{
+	_endpoints.erase(std::remove(_endpoints.begin(), _endpoints.end(), endpoint), _endpoints.end());
+}
+
+/// @brief
+/// @param fromIp4
+/// @param data
+/// @param len
+/// @return
+bool SimulatedIcmpTransport::Deliver(const uint32_t fromIp4, const unsigned char *data, const uint16_t len)
+{
+	if (_mailbox.size() >= _network.MailboxSize())
+		return false;
+	Received received;
+	received.fromIp4 = fromIp4;
+	received.len = len;
+	memcpy(received.data, data, len);
+	_mailbox.push_back(received);
+	return true;
+}
+
+/// @brief
+/// @return
+PingStatus SimulatedIcmpTransport::Open()
+{
+	_mailbox.clear();
+	_mailbox.reserve(_network.MailboxSize());
+	_network.Attach(this);
+	_open = true;
+	return PingStatus();
+}
+
+/// @brief
+void SimulatedIcmpTransport::Close()
+{
+	if (!_open)
+		return;
+	_network.Detach(this);
+	_mailbox.clear();
+	_open = false;
+}
+
+/// @brief
+/// @param ip4
+/// @param data
+/// @param size
+/// @return
+PingStatus SimulatedIcmpTransport::Send(const uint32_t ip4, const unsigned char *data, const uint16_t size)
+{
+	if (!_open)
+		return PingStatus(PING_ERR_SEND_FAILED, EBADF);
+	_network.Transmit(ip4, data, size);
+	return PingStatus();
+}
+
+/// @brief Runs the virtual clock forward until a message arrives or the timeout is up
+/// @param buffer
+/// @param bufferSize
+/// @param len
+/// @param fromIp4
+/// @param timeoutUs
+/// @return
+PingStatus SimulatedIcmpTransport::Receive(unsigned char *buffer, const uint16_t bufferSize,
+										   uint16_t &len, uint32_t &fromIp4, const uint32_t timeoutUs)
+{
+	len = 0u;
+	fromIp4 = 0u;
+	if (!_open)
+		return PingStatus(PING_ERR_RECEIVE_FAILED, EBADF);
+	const auto deadlineUs = _network.NowUs() + timeoutUs;
+	while (_mailbox.empty())
+	{
+		const auto nextUs = _network.NextDeliveryUs();
+		if (nextUs < 0 || nextUs > deadlineUs)
+		{
+			_network.AdvanceTo(deadlineUs);
+			if (_mailbox.empty())
+				return PingStatus(PING_ERR_TIMEOUT);
+			break;
+		}
+		_network.AdvanceTo(nextUs);
+	}
+	const auto &received = _mailbox.front();
+	len = received.len < bufferSize ? received.len : bufferSize;
+	memcpy(buffer, received.data, len);
+	fromIp4 = received.fromIp4;
+	_mailbox.erase(_mailbox.begin());
+	return PingStatus();
+}
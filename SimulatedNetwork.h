@@ -0,0 +1,224 @@
+// (c) Copyright 2024 Fatlab Software Pty Ltd.
+//
+// ICMP Ping library for the ESP32
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110 - 1301  USA
+#pragma once
+
+// In memory network on a virtual clock - deterministic for a given seed.
+// No Arduino or lwIP dependencies (nor in its PingRateLimiter) so it also builds for the host.
+
+#include <cstdint>
+#include <vector>
+
+#include "IcmpTransport.h"
+
+/// <summary>
+/// How one target behaves. Delays are one way, so the RTT is forward + reverse.
+/// Rates are probabilities 0.0 - 1.0, applied per message.
+/// </summary>
+struct SimulatedLinkProfile
+{
+	enum Distribution : uint8_t
+	{
+		LATENCY_FIXED = 0,	// Always the base delay
+		LATENCY_UNIFORM,	// Base + 0..jitter
+		LATENCY_EXPONENTIAL // Base + exponential with mean jitter - queueing delay
+	};
+
+	bool alive;
+	Distribution distribution;
+	uint32_t forwardDelayUs;
+	uint32_t reverseDelayUs;
+	uint32_t jitterUs;
+	float lossRate;		 // Each way
+	float duplicateRate; // Reply delivered twice
+	float reorderRate;	 // Reply held back by reorderDelayUs, letting later ones overtake it
+	uint32_t reorderDelayUs;
+	float corruptRate; // One bit of the reply flipped
+	bool answersTimestamps;
+	int32_t clockOffsetMs; // Target's time of day less the virtual clock's
+
+	/// @brief A host which answers in 1 ms every time
+	/// @return
+	static SimulatedLinkProfile Default()
+	{
+		return SimulatedLinkProfile{true, LATENCY_FIXED, 500u, 500u, 0u, 0.0f, 0.0f, 0.0f, 0u, 0.0f, true, 0};
+	}
+	/// @brief Nothing answers
+	/// @return
+	static SimulatedLinkProfile Dead()
+	{
+		auto profile = Default();
+		profile.alive = false;
+		return profile;
+	}
+};
+
+/// <summary>
+/// Counters for what the simulated network did to the traffic
+/// </summary>
+struct SimulatedNetworkCounters
+{
+	uint32_t sent;
+	uint32_t answered;
+	uint32_t lost;
+	uint32_t duplicated;
+	uint32_t reordered;
+	uint32_t corrupted;
+	uint32_t delivered;
+	uint32_t overflowed; // Dropped because an endpoint's receive mailbox was full
+};
+
+class SimulatedIcmpTransport;
+
+/// <summary>
+/// Targets, the messages in flight between them and the endpoints, and the virtual clock.
+/// Like lwIP raw sockets every open endpoint sees every reply.
+/// Single threaded - drive every endpoint from the same task.
+/// </summary>
+class SimulatedNetwork
+{
+public:
+	constexpr static uint16_t MAX_MESSAGE_BYTES = 64;
+	constexpr static uint8_t DEFAULT_MAILBOX_SIZE = 6; // As lwIP raw sockets on the ESP32
+
+private:
+	struct HostProfile
+	{
+		uint32_t ip4;
+		SimulatedLinkProfile profile;
+	};
+	struct Message
+	{
+		int64_t deliverAtUs;
+		uint64_t order; // Ties broken in send order
+		uint32_t fromIp4;
+		uint16_t len;
+		unsigned char data[MAX_MESSAGE_BYTES];
+	};
+
+private:
+	int64_t _nowUs;
+	uint64_t _random;
+	uint64_t _order;
+	uint8_t _mailboxSize;
+	SimulatedLinkProfile _defaultProfile;
+	std::vector<HostProfile> _profiles; // Sorted by address
+	std::vector<Message> _inFlight;		// Min heap on delivery time
+	std::vector<SimulatedIcmpTransport *> _endpoints;
+	SimulatedNetworkCounters _counters;
+	PingRateLimiter _rateLimiter; // Timed by the virtual clock
+
+private:
+	uint64_t NextRandom();
+	float RandomUnit();
+	uint32_t SampleDelayUs(const SimulatedLinkProfile &profile, uint32_t baseUs);
+	bool Chance(float rate) { return rate > 0.0f && RandomUnit() < rate; }
+	void Schedule(const Message &message);
+	bool Reply(const SimulatedLinkProfile &profile, const unsigned char *request, uint16_t size, Message &reply) const;
+	static void StampTimestampReply(const SimulatedLinkProfile &profile, int64_t arrivedUs, Message &reply);
+
+public:
+	/// @brief
+	/// @param seed Same seed, same run
+	explicit SimulatedNetwork(uint64_t seed = 1u);
+
+	SimulatedNetwork(const SimulatedNetwork &) = delete;
+	SimulatedNetwork &operator=(const SimulatedNetwork &) = delete;
+
+public:
+	/// @brief Profile for any host without its own
+	/// @param profile
+	void SetDefaultProfile(const SimulatedLinkProfile &profile) { _defaultProfile = profile; }
+	void SetProfile(uint32_t ip4, const SimulatedLinkProfile &profile);
+	const SimulatedLinkProfile &Profile(uint32_t ip4) const;
+	void SetMailboxSize(uint8_t size) { _mailboxSize = size > 0u ? size : 1u; }
+	uint8_t MailboxSize() const { return _mailboxSize; }
+
+	const SimulatedNetworkCounters &Counters() const { return _counters; }
+	PingRateLimiter &RateLimiter() { return _rateLimiter; }
+	uint32_t InFlightCount() const { return static_cast<uint32_t>(_inFlight.size()); }
+
+public:
+	int64_t NowUs() const { return _nowUs; }
+
+	/// @brief Move the clock forward, delivering everything due on the way
+	/// @param timeUs
+	void AdvanceTo(int64_t timeUs);
+
+	/// @brief
+	/// @return Delivery time of the next message, -1 if none
+	int64_t NextDeliveryUs() const { return _inFlight.empty() ? -1 : _inFlight.front().deliverAtUs; }
+
+	/// @brief A message from an endpoint onto the network
+	/// @param ip4
+	/// @param data
+	/// @param size
+	void Transmit(uint32_t ip4, const unsigned char *data, uint16_t size);
+
+	void Attach(SimulatedIcmpTransport *endpoint);
+	void Detach(SimulatedIcmpTransport *endpoint);
+};
+
+/// <summary>
+/// One endpoint (socket) on a SimulatedNetwork
+/// </summary>
+class SimulatedIcmpTransport : public IcmpTransport
+{
+	friend class SimulatedNetwork;
+
+private:
+	struct Received
+	{
+		uint32_t fromIp4;
+		uint16_t len;
+		unsigned char data[SimulatedNetwork::MAX_MESSAGE_BYTES];
+	};
+
+private:
+	SimulatedNetwork &_network;
+	std::vector<Received> _mailbox; // Oldest first
+	bool _open;
+
+private:
+	/// @brief
+	/// @param fromIp4
+	/// @param data
+	/// @param len
+	/// @return false if the mailbox was full
+	bool Deliver(uint32_t fromIp4, const unsigned char *data, uint16_t len);
+
+public:
+	/// @brief
+	/// @param network
+	explicit SimulatedIcmpTransport(SimulatedNetwork &network)
+		: _network(network), _open(false) {}
+	~SimulatedIcmpTransport() override { Close(); }
+
+	SimulatedIcmpTransport(const SimulatedIcmpTransport &) = delete;
+	SimulatedIcmpTransport &operator=(const SimulatedIcmpTransport &) = delete;
+
+public:
+	bool IsOpen() const { return _open; }
+
+	PingStatus Open() override;
+	void Close() override;
+	PingStatus Send(uint32_t ip4, const unsigned char *data, uint16_t size) override;
+	PingStatus Receive(unsigned char *buffer, uint16_t bufferSize,
+					   uint16_t &len, uint32_t &fromIp4, uint32_t timeoutUs) override;
+	int64_t NowUs() override { return _network.NowUs(); }
+	void WaitUntilUs(int64_t deadlineUs) override { _network.AdvanceTo(deadlineUs); }
+	PingRateLimiter &RateLimiter() override { return _network.RateLimiter(); }
+};
@@ -25,7 +25,8 @@ Esp32IcmpPing pingClient(google, 4, 500);
  void callPing(String* s=nullptr) 
 {
     PingResults results;
-    if(pingClient.ping(results, &Serial))
+    PingStatus status = pingClient.ping(results, &Serial);
+    if(status)
     {
       results.PrintState(&Serial);
       if(s!=nullptr)
@@ -34,7 +35,7 @@ Esp32IcmpPing pingClient(google, 4, 500);
     else
     {
        if(s!=nullptr)
-          *s="Failed Ping!";
+          *s=String("Failed Ping! ") + status.ToString();
     }
 }
 
@@ -0,0 +1,530 @@
+// (c) Copyright 2024 Fatlab Software Pty Ltd.
+//
+// ICMP Ping library for the ESP32
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110 - 1301  USA
+
+// Deterministic scenarios on the simulated network - each runs twice on fresh
+// networks with the same seed and must give the same results both times.
+
+#include "Esp32IcmpPing.h"
+#include "Esp32IcmpSweep.h"
+#include "PingTargetTable.h"
+#include "SimulatedNetwork.h"
+
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+
+static int failures = 0;
+
+#define CHECK(cond)                                                       \
+	do                                                                    \
+	{                                                                     \
+		if (!(cond))                                                      \
+		{                                                                 \
+			printf("FAILED %s:%d: %s\r\n", __FILE__, __LINE__, #cond); \
+			failures++;                                                   \
+		}                                                                 \
+	} while (0)
+
+/// @brief Same counters and phase timings
+/// @param a
+/// @param b
+/// @return
+static bool SameStats(const PingStats &a, const PingStats &b)
+{
+	for (uint8_t i = 0u; i < PingStats::PHASE_COUNT; ++i)
+	{
+		const auto phase = static_cast<PingStats::Phase>(i);
+		if (a.Timing(phase).calls != b.Timing(phase).calls ||
+			a.Timing(phase).totalMicros != b.Timing(phase).totalMicros ||
+			a.Timing(phase).maxMicros != b.Timing(phase).maxMicros)
+			return false;
+	}
+	return a.Timeouts() == b.Timeouts() &&
+		   a.InvalidReplies() == b.InvalidReplies() &&
+		   a.LateReplies() == b.LateReplies() &&
+		   a.PacketsSent() == b.PacketsSent() &&
+		   a.PacketsReceived() == b.PacketsReceived() &&
+		   a.ResolveFailures() == b.ResolveFailures();
+}
+
+/// <summary>
+/// ping() over a lossy, jittery link which duplicates, reorders and corrupts replies
+/// </summary>
+struct PingRun
+{
+	uint16_t received[3];
+	uint32_t totalMs[3];
+	float aveMs[3];
+	uint32_t srttUs;
+	int64_t endUs;
+	PingStats stats;
+
+	void Run(const uint64_t seed)
+	{
+		SimulatedNetwork network(seed);
+		auto lossy = SimulatedLinkProfile::Default();
+		lossy.distribution = SimulatedLinkProfile::LATENCY_EXPONENTIAL;
+		lossy.jitterUs = 2000u;
+		lossy.lossRate = 0.1f;
+		lossy.duplicateRate = 0.05f;
+		lossy.reorderRate = 0.05f;
+		lossy.reorderDelayUs = 30000u;
+		lossy.corruptRate = 0.02f;
+		network.SetDefaultProfile(lossy);
+		SimulatedIcmpTransport transport(network);
+		Esp32IcmpPing pingClient(IPAddress(10, 0, 0, 1), 10, 1000);
+		pingClient.SetTransport(&transport);
+		pingClient.SetAdaptiveTimeout(5);
+		pingClient.SetInterval(100);
+		for (auto i = 0u; i < 3u; ++i)
+		{
+			PingResults results;
+			const auto status = pingClient.ping(results);
+			CHECK(status);
+			CHECK(results.IsValid());
+			CHECK(results.Transmitted() == 10u);
+			received[i] = results.Received();
+			totalMs[i] = results.TotalTimeMs();
+			aveMs[i] = results.AveTimeMs();
+		}
+		srttUs = pingClient.Rtt().SmoothedRttUs();
+		endUs = network.NowUs();
+		stats = pingClient.Stats();
+		CHECK(stats.PacketsSent() == 30u);
+	}
+	bool operator==(const PingRun &other) const
+	{
+		for (auto i = 0u; i < 3u; ++i)
+		{
+			if (received[i] != other.received[i] || totalMs[i] != other.totalMs[i] || aveMs[i] != other.aveMs[i])
+				return false;
+		}
+		return srttUs == other.srttUs && endUs == other.endUs && SameStats(stats, other.stats);
+	}
+};
+
+/// @brief
+static void PingScenario()
+{
+	PingRun first, second;
+	first.Run(42u);
+	second.Run(42u);
+	CHECK(first == second);
+	printf("ping: received %u/%u/%u of 10, srtt %u us, %lld us\r\n",
+		   (unsigned int)first.received[0], (unsigned int)first.received[1], (unsigned int)first.received[2],
+		   (unsigned int)first.srttUs, (long long)first.endUs);
+}
+
+/// @brief The rate limiter is timed by each network's own clock
+static void RateLimitScenario()
+{
+	uint32_t totalMs[2];
+	for (auto i = 0u; i < 2u; ++i)
+	{
+		SimulatedNetwork network(1u);
+		network.RateLimiter().Configure(10, 1);
+		SimulatedIcmpTransport transport(network);
+		Esp32IcmpPing pingClient(IPAddress(10, 0, 0, 1), 4, 1000);
+		pingClient.SetTransport(&transport);
+		PingResults results;
+		CHECK(pingClient.ping(results));
+		totalMs[i] = results.TotalTimeMs();
+	}
+	// 4 probes 100 ms apart, the last answered in 1 ms
+	CHECK(totalMs[0] == 301u);
+	CHECK(totalMs[1] == totalMs[0]);
+	printf("rate limit: %u ms, %u ms\r\n", (unsigned int)totalMs[0], (unsigned int)totalMs[1]);
+}
+
+/// <summary>
+/// Runs another ping the first time its owner waits between paced probes -
+/// two instances on one clock, interleaved as if in different tasks
+/// </summary>
+class InterleavingTransport : public SimulatedIcmpTransport
+{
+private:
+	void (*_interleave)(void *);
+	void *_context;
+
+public:
+	explicit InterleavingTransport(SimulatedNetwork &network, void (*interleave)(void *), void *context)
+		: SimulatedIcmpTransport(network), _interleave(interleave), _context(context) {}
+
+	void WaitUntilUs(int64_t deadlineUs) override
+	{
+		if (_interleave != nullptr)
+		{
+			auto interleave = _interleave;
+			_interleave = nullptr;
+			interleave(_context);
+		}
+		SimulatedIcmpTransport::WaitUntilUs(deadlineUs);
+	}
+};
+
+/// <summary>
+/// Instance B pings while paced instance A waits for its next slot
+/// </summary>
+struct PacingRun
+{
+	SimulatedNetwork &network;
+	SimulatedIcmpTransport transport;
+	Esp32IcmpPing pingClient;
+	PingResults results;
+	PingStatus status;
+
+	explicit PacingRun(SimulatedNetwork &net)
+		: network(net), transport(net), pingClient(IPAddress(10, 0, 0, 2), 1, 1000)
+	{
+		pingClient.SetTransport(&transport);
+	}
+
+	static void Ping(void *context)
+	{
+		auto &run = *static_cast<PacingRun *>(context);
+		// Half way through A's interval - the bucket has long since refilled
+		run.transport.WaitUntilUs(500000);
+		run.status = run.pingClient.ping(run.results);
+	}
+};
+
+/// @brief A paced instance must not book its token ahead of its slot
+static void PacingScenario()
+{
+	SimulatedNetwork network(5u);
+	network.RateLimiter().Configure(10, 1);
+	PacingRun other(network);
+	InterleavingTransport pacedTransport(network, PacingRun::Ping, &other);
+	Esp32IcmpPing paced(IPAddress(10, 0, 0, 1), 2, 1000);
+	paced.SetTransport(&pacedTransport);
+	paced.SetInterval(1000);
+	PingResults results;
+	CHECK(paced.ping(results));
+	CHECK(results.Received() == 2u);
+	// Second probe on its schedule, answered in 1 ms
+	CHECK(results.TotalTimeMs() == 1001u);
+	CHECK(other.status);
+	// Sent as soon as asked, not after A's next slot
+	CHECK(other.pingClient.Stats().Timing(PingStats::PHASE_PACING).maxMicros == 0u);
+	CHECK(other.results.TotalTimeMs() == 1u);
+	printf("pacing: paced %u ms, other %u ms\r\n",
+		   (unsigned int)results.TotalTimeMs(), (unsigned int)other.results.TotalTimeMs());
+}
+
+/// @brief
+/// @param
+/// @param
+/// @param context
+static void CountAlive(uint32_t, float, void *context)
+{
+	(*static_cast<uint32_t *>(context))++;
+}
+
+/// @brief A /24 with every third host up
+static void SweepScenario()
+{
+	uint32_t alive[2] = {0u, 0u};
+	uint32_t totalMs[2];
+	PingStats stats[2];
+	for (auto i = 0u; i < 2u; ++i)
+	{
+		SimulatedNetwork network(7u);
+		network.SetDefaultProfile(SimulatedLinkProfile::Dead());
+		auto up = SimulatedLinkProfile::Default();
+		up.distribution = SimulatedLinkProfile::LATENCY_UNIFORM;
+		up.jitterUs = 3000u;
+		for (auto host = 1u; host < 255u; host += 3u)
+			network.SetProfile(IPAddress(192, 168, 1, static_cast<uint8_t>(host)), up);
+		SimulatedIcmpTransport transport(network);
+		Esp32IcmpSweep sweeper("192.168.1.0/24");
+		sweeper.SetTransport(&transport);
+		CHECK(sweeper.sweep(CountAlive, &alive[i]));
+		CHECK(sweeper.ProbedCount() == 254u);
+		CHECK(sweeper.AliveCount() == 85u);
+		totalMs[i] = sweeper.TotalTimeMs();
+		stats[i] = sweeper.Stats();
+	}
+	CHECK(alive[0] == 85u);
+	CHECK(alive[1] == alive[0]);
+	CHECK(totalMs[1] == totalMs[0]);
+	CHECK(SameStats(stats[0], stats[1]));
+	printf("sweep: %u alive, %u ms\r\n", (unsigned int)alive[0], (unsigned int)totalMs[0]);
+}
+
+/// <summary>
+/// Fails every Nth send as lwIP does when short of pbufs
+/// </summary>
+class FailingSendTransport : public SimulatedIcmpTransport
+{
+private:
+	uint32_t _every;
+	uint32_t _sends;
+
+public:
+	explicit FailingSendTransport(SimulatedNetwork &network, const uint32_t every)
+		: SimulatedIcmpTransport(network), _every(every), _sends(0u) {}
+
+	PingStatus Send(uint32_t ip4, const unsigned char *data, uint16_t size) override
+	{
+		if (++_sends % _every == 0u)
+			return PingStatus(PING_ERR_SEND_FAILED, ENOMEM);
+		return SimulatedIcmpTransport::Send(ip4, data, size);
+	}
+	uint32_t Sends() const { return _sends; }
+};
+
+/// <summary>
+/// Callbacks of a sweep - those without an RTT counted apart
+/// </summary>
+struct SweepCallbacks
+{
+	uint32_t alive;
+	uint32_t untimed;
+
+	static void OnAlive(uint32_t, float rttMs, void *context)
+	{
+		auto &callbacks = *static_cast<SweepCallbacks *>(context);
+		callbacks.alive++;
+		if (std::isnan(rttMs))
+			callbacks.untimed++;
+	}
+};
+
+constexpr static uint32_t SLOW_HOST_COUNT = 7u;
+constexpr static uint32_t SUBNET_HOST_COUNT = 14u;
+
+/// @brief A /28 - the first 7 hosts answer after the sweep's timeout, the rest not at all
+/// @param network
+static void SetUpSlowSubnet(SimulatedNetwork &network)
+{
+	network.SetDefaultProfile(SimulatedLinkProfile::Dead());
+	auto slow = SimulatedLinkProfile::Default();
+	slow.forwardDelayUs = 300000u;
+	slow.reverseDelayUs = 300000u;
+	for (auto host = 1u; host <= SLOW_HOST_COUNT; ++host)
+		network.SetProfile(IPAddress(172, 16, 0, static_cast<uint8_t>(host)), slow);
+}
+
+/// @brief Retries, and replies to the first try turning up after the retry went out
+static void SweepRetryScenario()
+{
+	{
+		SimulatedNetwork network(11u);
+		SetUpSlowSubnet(network);
+		SimulatedIcmpTransport transport(network);
+		Esp32IcmpSweep sweeper("172.16.0.0/28", 6, 500, 1);
+		sweeper.SetTransport(&transport);
+		SweepCallbacks callbacks = {0u, 0u};
+		CHECK(sweeper.sweep(SweepCallbacks::OnAlive, &callbacks));
+		CHECK(sweeper.ProbedCount() == SUBNET_HOST_COUNT);
+		CHECK(callbacks.alive == SLOW_HOST_COUNT);
+		// 600 ms replies to the first try land after the 500 ms retry - no RTT for them
+		CHECK(callbacks.untimed == SLOW_HOST_COUNT);
+		const auto stats = sweeper.Stats();
+		// Slow hosts time out once, dead ones on both tries
+		CHECK(stats.Timeouts() == SLOW_HOST_COUNT + 2u * (SUBNET_HOST_COUNT - SLOW_HOST_COUNT));
+		// Every host probed and retried once
+		CHECK(stats.PacketsSent() == 2u * SUBNET_HOST_COUNT);
+		printf("sweep retry: %u alive, %u untimed, %u timeouts, %u sent\r\n",
+			   (unsigned int)callbacks.alive, (unsigned int)callbacks.untimed,
+			   (unsigned int)stats.Timeouts(), (unsigned int)stats.PacketsSent());
+	}
+	{
+		// Failed sends count as timed out tries - the sweep carries on
+		SimulatedNetwork network(11u);
+		SetUpSlowSubnet(network);
+		FailingSendTransport transport(network, 4u);
+		Esp32IcmpSweep sweeper("172.16.0.0/28", 6, 500, 1);
+		sweeper.SetTransport(&transport);
+		SweepCallbacks callbacks = {0u, 0u};
+		CHECK(sweeper.sweep(SweepCallbacks::OnAlive, &callbacks));
+		CHECK(sweeper.ProbedCount() == SUBNET_HOST_COUNT);
+		const auto stats = sweeper.Stats();
+		CHECK(stats.ErrnoCountFor(ENOMEM) == transport.Sends() / 4u);
+		CHECK(stats.ErrnoCountFor(ENOMEM) > 0u);
+		CHECK(stats.PacketsSent() + stats.ErrnoCountFor(ENOMEM) == transport.Sends());
+		CHECK(callbacks.alive > 0u);
+		printf("sweep send failures: %u of %u sends failed, %u alive\r\n",
+			   (unsigned int)stats.ErrnoCountFor(ENOMEM), (unsigned int)transport.Sends(),
+			   (unsigned int)callbacks.alive);
+	}
+}
+
+/// @brief Timestamp probes on an asymmetric link, against a target whose clock is off
+static void TimestampScenario()
+{
+	float offsetMs[2];
+	for (auto i = 0u; i < 2u; ++i)
+	{
+		SimulatedNetwork network(3u);
+		auto asymmetric = SimulatedLinkProfile::Default();
+		asymmetric.forwardDelayUs = 20000u;
+		asymmetric.reverseDelayUs = 5000u;
+		asymmetric.clockOffsetMs = -123456;
+		network.SetDefaultProfile(asymmetric);
+		SimulatedIcmpTransport transport(network);
+		Esp32IcmpPing pingClient(IPAddress(10, 0, 0, 1), 10, 1000);
+		pingClient.SetTransport(&transport);
+		pingClient.SetAdaptiveTimeout(5);
+		PingResults results;
+		CHECK(pingClient.ping(results));
+		const auto srttUs = pingClient.Rtt().SmoothedRttUs();
+		const auto rttVarUs = pingClient.Rtt().RttVarianceUs();
+		PingTimestampResults timestamps;
+		CHECK(pingClient.pingTimestamp(timestamps));
+		CHECK(timestamps.IsValid());
+		CHECK(timestamps.Received() == 10u);
+		// Timestamp round trips leave the echo timeout alone
+		CHECK(pingClient.Rtt().SmoothedRttUs() == srttUs);
+		CHECK(pingClient.Rtt().RttVarianceUs() == rttVarUs);
+		CHECK(pingClient.TimestampRtt().HasSample());
+		// A fixed asymmetry is split evenly - (20 - 5) / 2 ms shows up in the offset, give or take the ms resolution
+		CHECK(fabsf(timestamps.ClockOffsetMs() - (-123456.0f + 7.5f)) <= 1.0f);
+		CHECK(fabsf(timestamps.MinForwardMs() + timestamps.MinReverseMs() - 25.0f) <= 1.0f);
+		offsetMs[i] = timestamps.ClockOffsetMs();
+	}
+	CHECK(offsetMs[1] == offsetMs[0]);
+	printf("timestamp: offset %.1f ms\r\n", offsetMs[0]);
+}
+
+constexpr static uint16_t TARGET_COUNT = 10000u;
+constexpr static uint16_t MISSING_NAME_COUNT = 10u;
+constexpr static uint32_t PINGED_COUNT = TARGET_COUNT - MISSING_NAME_COUNT;
+
+// Too big for the stack
+static PingTargetTable<TARGET_COUNT> targets;
+
+/// @brief Address of target i - 10.0.0.0/16 and on
+/// @param i
+/// @return
+static uint32_t TargetAddress(const uint16_t i)
+{
+	return IPAddress(10, static_cast<uint8_t>(i >> 8), static_cast<uint8_t>(i), 1);
+}
+
+/// @brief Every seventh target is down
+/// @param i
+/// @return
+static bool IsTargetUp(const uint16_t i) { return i % 7u != 0u; }
+
+/// <summary>
+/// PingAll() over 10,000 targets - one in ten by name, a few of them unresolvable
+/// </summary>
+struct PingAllRun
+{
+	uint16_t alive;
+	uint32_t callbacks;
+	uint32_t lookups;		// Names looked up by PingAll()
+	uint32_t retryLookups; // By Ping() of one unresolved target
+	int64_t endUs;
+	PingStats stats;
+
+	static void OnResult(uint16_t, const PingStatus &, const PingResults &, void *context)
+	{
+		static_cast<PingAllRun *>(context)->callbacks++;
+	}
+
+	void Run(const uint64_t seed)
+	{
+		callbacks = 0u;
+		SimulatedNetwork network(seed);
+		network.SetDefaultProfile(SimulatedLinkProfile::Dead());
+		auto up = SimulatedLinkProfile::Default();
+		up.distribution = SimulatedLinkProfile::LATENCY_EXPONENTIAL;
+		up.jitterUs = 1000u;
+		WiFi.ClearHosts();
+		targets.Clear();
+		targets.ResetStats();
+		for (uint16_t i = 0u; i < TARGET_COUNT; ++i)
+		{
+			if (IsTargetUp(i))
+				network.SetProfile(TargetAddress(i), up);
+			char host[16];
+			if (i < MISSING_NAME_COUNT)
+			{
+				snprintf(host, sizeof(host), "missing-%u", (unsigned int)i);
+				CHECK(targets.Add(host, 1, 100) == i);
+			}
+			else if (i % 10u == 0u)
+			{
+				snprintf(host, sizeof(host), "host-%u", (unsigned int)i);
+				WiFi.AddHost(host, TargetAddress(i));
+				CHECK(targets.Add(host, 1, 100) == i);
+			}
+			else
+				CHECK(targets.Add(TargetAddress(i), 1, 100) == i);
+		}
+		SimulatedIcmpTransport transport(network);
+		WiFi.ResetLookupCount();
+		alive = targets.PingAll(OnResult, this, &transport);
+		lookups = WiFi.LookupCount();
+		endUs = network.NowUs();
+		stats = targets.Stats();
+		WiFi.ResetLookupCount();
+		PingResults results;
+		CHECK(targets.Ping(0u, results, &transport).Error() == PING_ERR_RESOLVE_FAILED);
+		retryLookups = WiFi.LookupCount();
+	}
+};
+
+/// @brief
+static void PingAllScenario()
+{
+	uint16_t expected = 0u;
+	for (uint16_t i = MISSING_NAME_COUNT; i < TARGET_COUNT; ++i)
+	{
+		if (IsTargetUp(i))
+			expected++;
+	}
+	PingAllRun first, second;
+	first.Run(9u);
+	second.Run(9u);
+	CHECK(first.callbacks == TARGET_COUNT);
+	CHECK(first.alive == expected);
+	CHECK(second.alive == first.alive);
+	CHECK(second.endUs == first.endUs);
+	// Every name once - not again for each target whose name failed
+	CHECK(first.lookups == targets.NameCount());
+	CHECK(first.retryLookups == 1u);
+	// The table's stats cover every target pinged
+	CHECK(first.stats.ResolveFailures() == MISSING_NAME_COUNT);
+	CHECK(first.stats.PacketsSent() == PINGED_COUNT);
+	CHECK(first.stats.PacketsReceived() == first.alive);
+	CHECK(first.stats.Timeouts() == PINGED_COUNT - first.alive);
+	CHECK(first.stats.Timing(PingStats::PHASE_SEND).calls == PINGED_COUNT);
+	CHECK(SameStats(first.stats, second.stats));
+	printf("ping all: %u of %u alive, %u look ups, %lld us\r\n",
+		   (unsigned int)first.alive, (unsigned int)TARGET_COUNT, (unsigned int)first.lookups, (long long)first.endUs);
+}
+
+int main()
+{
+	PingScenario();
+	RateLimitScenario();
+	PacingScenario();
+	SweepScenario();
+	SweepRetryScenario();
+	TimestampScenario();
+	PingAllScenario();
+	if (failures > 0)
+	{
+		printf("%d checks failed\r\n", failures);
+		return 1;
+	}
+	printf("All scenarios passed\r\n");
+	return 0;
+}
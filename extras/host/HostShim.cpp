@@ -0,0 +1,93 @@
+// (c) Copyright 2024 Fatlab Software Pty Ltd.
+//
+// ICMP Ping library for the ESP32
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110 - 1301  USA
+
+// Host build only - bodies for the shim headers
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <esp_timer.h>
+
+#include "lwip/inet_chksum.h"
+#include "lwip/sockets.h"
+
+#include <chrono>
+#include <thread>
+
+HardwareSerial Serial;
+WiFiClass WiFi;
+
+static const auto started = std::chrono::steady_clock::now();
+
+/// @brief
+/// @return
+int64_t esp_timer_get_time()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started).count();
+}
+
+unsigned long micros() { return static_cast<unsigned long>(esp_timer_get_time()); }
+unsigned long millis() { return static_cast<unsigned long>(esp_timer_get_time() / 1000); }
+void delay(const uint32_t ms) { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+void delayMicroseconds(const uint32_t us) { std::this_thread::sleep_for(std::chrono::microseconds(us)); }
+void yield() {}
+
+/// @brief
+/// @param host
+/// @param result
+/// @return
+int WiFiClass::hostByName(const char *host, IPAddress &result)
+{
+	_lookups++;
+	in_addr addr;
+	if (inet_pton(AF_INET, host, &addr) == 1)
+	{
+		result = IPAddress(static_cast<uint32_t>(addr.s_addr));
+		return 1;
+	}
+	const auto found = _hosts.find(host);
+	if (found == _hosts.end())
+		return 0;
+	result = IPAddress(found->second);
+	return 1;
+}
+
+/// @brief
+/// @param data
+/// @param len
+/// @return
+uint16_t inet_chksum(const void *data, const uint16_t len)
+{
+	const auto bytes = static_cast<const uint8_t *>(data);
+	uint32_t sum = 0u;
+	for (auto i = 0u; i + 1u < len; i += 2u)
+		sum += (static_cast<uint32_t>(bytes[i]) << 8) | bytes[i + 1u];
+	if (len & 1u)
+		sum += static_cast<uint32_t>(bytes[len - 1u]) << 8;
+	while (sum >> 16)
+		sum = (sum & 0xFFFFu) + (sum >> 16);
+	return htons(static_cast<uint16_t>(~sum & 0xFFFFu));
+}
+
+/// @brief
+/// @param addr
+/// @return
+char *inet_ntoa(const ip4_addr_t addr)
+{
+	in_addr in;
+	in.s_addr = addr.addr;
+	return inet_ntoa(in);
+}
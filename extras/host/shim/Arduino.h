@@ -0,0 +1,128 @@
+// (c) Copyright 2024 Fatlab Software Pty Ltd.
+//
+// ICMP Ping library for the ESP32
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110 - 1301  USA
+#pragma once
+
+// Host build only - the parts of the Arduino core the library uses
+
+#include <cerrno>
+#include <cmath>
+#include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+/// <summary>
+/// Heap string - as much of Arduino's String as the library uses
+/// </summary>
+class String
+{
+private:
+	std::string _s;
+
+public:
+	String(const char *s = "") : _s(s != nullptr ? s : "") {}
+
+public:
+	unsigned int length() const { return static_cast<unsigned int>(_s.size()); }
+	const char *c_str() const { return _s.c_str(); }
+	String &operator+=(const char *s)
+	{
+		_s += s;
+		return *this;
+	}
+	String &operator+=(const String &s)
+	{
+		_s += s._s;
+		return *this;
+	}
+	bool operator==(const String &s) const { return _s == s._s; }
+};
+
+/// <summary>
+/// Formatted output onto write()
+/// </summary>
+class Print
+{
+public:
+	virtual ~Print() {}
+	virtual size_t write(const uint8_t *buffer, size_t size) = 0;
+
+public:
+	size_t print(const char *s) { return write(reinterpret_cast<const uint8_t *>(s), strlen(s)); }
+	size_t print(const String &s) { return print(s.c_str()); }
+	size_t print(int value) { return printf("%d", value); }
+	size_t println(const char *s = "") { return print(s) + print("\r\n"); }
+	size_t println(const String &s) { return println(s.c_str()); }
+	size_t printf(const char *format, ...)
+	{
+		char buffer[256];
+		va_list args;
+		va_start(args, format);
+		const auto len = vsnprintf(buffer, sizeof(buffer), format, args);
+		va_end(args);
+		if (len <= 0)
+			return 0;
+		return write(reinterpret_cast<const uint8_t *>(buffer), strlen(buffer));
+	}
+};
+
+/// <summary>
+/// Serial is stdout
+/// </summary>
+class HardwareSerial : public Print
+{
+public:
+	size_t write(const uint8_t *buffer, size_t size) override { return fwrite(buffer, 1, size, stdout); }
+};
+extern HardwareSerial Serial;
+
+/// <summary>
+/// IPv4 address - converts to uint32_t in network order, as on the ESP32
+/// </summary>
+class IPAddress
+{
+private:
+	uint8_t _bytes[4];
+
+public:
+	IPAddress() : _bytes{0u, 0u, 0u, 0u} {}
+	IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : _bytes{a, b, c, d} {}
+	IPAddress(uint32_t ip4) { memcpy(_bytes, &ip4, sizeof(_bytes)); }
+
+public:
+	operator uint32_t() const
+	{
+		uint32_t ip4;
+		memcpy(&ip4, _bytes, sizeof(ip4));
+		return ip4;
+	}
+	uint8_t operator[](int i) const { return _bytes[i]; }
+	String toString() const
+	{
+		char buffer[16];
+		snprintf(buffer, sizeof(buffer), "%u.%u.%u.%u", _bytes[0], _bytes[1], _bytes[2], _bytes[3]);
+		return String(buffer);
+	}
+};
+
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+void yield();
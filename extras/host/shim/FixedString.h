@@ -0,0 +1,52 @@
+// (c) Copyright 2024 Fatlab Software Pty Ltd.
+//
+// ICMP Ping library for the ESP32
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110 - 1301  USA
+#pragma once
+
+// Host build only - the part of the FixedString library the library uses
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+
+/// <summary>
+/// Fixed capacity string - truncates rather than allocates
+/// </summary>
+template <size_t N>
+class FixedString
+{
+private:
+	char _buffer[N];
+
+public:
+	FixedString(const char *s = "")
+	{
+		_buffer[0] = '\0';
+		if (s != nullptr)
+			snprintf(_buffer, N, "%s", s);
+	}
+
+public:
+	const char *c_str() const { return _buffer; }
+	size_t length() const { return strlen(_buffer); }
+	void format(const char *fmt, ...)
+	{
+		va_list args;
+		va_start(args, fmt);
+		vsnprintf(_buffer, N, fmt, args);
+		va_end(args);
+	}
+};
@@ -0,0 +1,53 @@
+// (c) Copyright 2024 Fatlab Software Pty Ltd.
+//
+// ICMP Ping library for the ESP32
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110 - 1301  USA
+#pragma once
+
+// Host build only - name lookups come from a table the scenarios fill in
+
+#include <map>
+#include <string>
+
+#include "Arduino.h"
+
+/// <summary>
+/// hostByName() answers dotted quads and names added with AddHost()
+/// </summary>
+class WiFiClass
+{
+private:
+	std::map<std::string, uint32_t> _hosts;
+	uint32_t _lookups;
+
+public:
+	WiFiClass() : _lookups(0u) {}
+
+public:
+	/// @brief
+	/// @param host
+	/// @param result
+	/// @return 1 if found, 0 if not
+	int hostByName(const char *host, IPAddress &result);
+
+	/// @brief
+	/// @param host
+	/// @param ip4 Network order
+	void AddHost(const char *host, uint32_t ip4) { _hosts[host] = ip4; }
+	void ClearHosts() { _hosts.clear(); }
+	uint32_t LookupCount() const { return _lookups; }
+	void ResetLookupCount() { _lookups = 0u; }
+};
+extern WiFiClass WiFi;
@@ -0,0 +1,39 @@
+// (c) Copyright 2024 Fatlab Software Pty Ltd.
+//
+// ICMP Ping library for the ESP32
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110 - 1301  USA
+#pragma once
+
+// Host build only - lwIP's ICMP types and echo header
+
+#include <arpa/inet.h>
+#include <cstdint>
+
+#include "lwip/ip.h"
+
+#define ICMP_ER 0	 // Echo reply
+#define ICMP_ECHO 8	 // Echo
+#define ICMP_TS 13	 // Timestamp
+#define ICMP_TSR 14 // Timestamp reply
+
+struct icmp_echo_hdr
+{
+	uint8_t type;
+	uint8_t code;
+	uint16_t chksum;
+	uint16_t id;
+	uint16_t seqno;
+};
+#define ICMPH_TYPE_SET(hdr, t) ((hdr)->type = (t))
@@ -0,0 +1,38 @@
+// (c) Copyright 2024 Fatlab Software Pty Ltd.
+//
+// ICMP Ping library for the ESP32
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110 - 1301  USA
+#pragma once
+
+// Host build only - lwIP's IPv4 header and memory size types
+
+#include <cstdint>
+
+typedef uint16_t mem_size_t;
+
+struct ip_hdr
+{
+	uint8_t _v_hl;
+	uint8_t _tos;
+	uint16_t _len;
+	uint16_t _id;
+	uint16_t _offset;
+	uint8_t _ttl;
+	uint8_t _proto;
+	uint16_t _chksum;
+	uint32_t src;
+	uint32_t dest;
+};
+#define IPH_HL(hdr) ((hdr)->_v_hl & 0x0f)
@@ -0,0 +1,44 @@
+// (c) Copyright 2024 Fatlab Software Pty Ltd.
+//
+// ICMP Ping library for the ESP32
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110 - 1301  USA
+#pragma once
+
+// Host build only - lwIP's BSD socket names onto the host's sockets
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "lwip/ip.h"
+
+#define closesocket(s) close(s)
+
+// lwIP's sockaddr_in has a length field, the host's may not - park it in the padding
+#define sin_len sin_zero[0]
+
+typedef struct
+{
+	uint32_t addr;
+} ip4_addr_t;
+
+/// @brief
+/// @param addr
+/// @return Static buffer
+char *inet_ntoa(ip4_addr_t addr);